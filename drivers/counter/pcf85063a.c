@@ -21,47 +21,163 @@
 #include <zephyr/sys/timeutil.h>
 
 #include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_calendar.h>
+
+#ifdef CONFIG_PCF85063A_FATFS_GET_FATTIME
+#include <ff.h>
+#endif
 
 #include <zephyr/logging/log.h>
-LOG_MODULE_REGISTER(pcf85063a);
+LOG_MODULE_REGISTER(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
 
 #define DT_DRV_COMPAT nxp_pcf85063a
 
+#include <drivers/counter/pcf85063a_bus.h>
+
 /*
- * Function from https://stackoverflow.com/questions/19377396/c-get-day-of-year-from-date
+ * All transfers go through the wrappers below. With accounting each one is
+ * charged to op, the public entry point it was made for. Wire bytes for a
+ * 7 bit address: register reads are address, register, repeated start,
+ * address and data; writes are address, register and data.
  */
-static int yisleap(int year)
+static int pcf85063a_bus_account(const char *op, uint32_t bytes, uint32_t starts, int ret)
 {
-	return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+#ifdef CONFIG_PCF85063A_BUS_ACCOUNTING
+	return pcf85063a_bus_charge(op, bytes, starts, ret);
+#else
+	ARG_UNUSED(op);
+	ARG_UNUSED(bytes);
+	ARG_UNUSED(starts);
+
+	return ret;
+#endif
 }
 
-/*
- * Function from https://stackoverflow.com/questions/19377396/c-get-day-of-year-from-date
- */
-static int get_yday(int mon, int day, int year)
+static int pcf85063a_bus_read_byte(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t *value,
+				   const char *op)
+{
+	return pcf85063a_bus_account(op, 4, 2, i2c_reg_read_byte_dt(spec, reg, value));
+}
+
+static int pcf85063a_bus_write_byte(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t value,
+				    const char *op)
+{
+	return pcf85063a_bus_account(op, 3, 1, i2c_reg_write_byte_dt(spec, reg, value));
+}
+
+/* A read and a write */
+static int pcf85063a_bus_update_byte(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t mask,
+				     uint8_t value, const char *op)
+{
+	return pcf85063a_bus_account(op, 7, 3, i2c_reg_update_byte_dt(spec, reg, mask, value));
+}
+
+static int pcf85063a_bus_burst_read(const struct i2c_dt_spec *spec, uint8_t reg, uint8_t *buf,
+				    uint32_t len, const char *op)
+{
+	return pcf85063a_bus_account(op, 3 + len, 2, i2c_burst_read_dt(spec, reg, buf, len));
+}
+
+static int pcf85063a_bus_burst_write(const struct i2c_dt_spec *spec, uint8_t reg,
+				     const uint8_t *buf, uint32_t len, const char *op)
+{
+	return pcf85063a_bus_account(op, 2 + len, 1, i2c_burst_write_dt(spec, reg, buf, len));
+}
+
+/* Without alarm support the counter API rejects every channel up front */
+#define PCF85063A_CHANNELS COND_CODE_1(CONFIG_PCF85063A_ALARM, (1), (0))
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+/* Change bits of the staged copy only, pcf85063a_commit() writes it out */
+static int pcf85063a_stage(const struct device *dev, uint8_t reg, uint8_t mask, uint8_t value)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	data->cfg_staged[reg] = (data->cfg_staged[reg] & ~mask) | (value & mask);
+
+	return 0;
+}
+
+/* Bits that take effect at once. The rest of the register is known, no read needed. */
+static int pcf85063a_write_through(const struct device *dev, uint8_t reg, uint8_t mask,
+				   uint8_t value, const char *op)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	uint8_t shadow = (data->cfg_shadow[reg] & ~mask) | (value & mask);
+	int ret;
+
+	ret = pcf85063a_bus_write_byte(&config->i2c, reg, shadow, op);
+	if (ret)
+	{
+		LOG_ERR("Unable to write RTC register 0x%02x. (err %i)", reg, ret);
+		return ret;
+	}
+
+	data->cfg_shadow[reg] = shadow;
+	data->cfg_staged[reg] = (data->cfg_staged[reg] & ~mask) | (value & mask);
+
+	return 0;
+}
+
+int pcf85063a_commit(const struct device *dev)
 {
-	static const int days[2][12] = {
-		{0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
-		{0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335}};
-	int leap = yisleap(year);
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
 
-	/* Minus 1 since gmtime starts from 0 */
-	return days[leap][mon] + day - 1;
+	for (size_t first = 0, end; first < ARRAY_SIZE(data->cfg_staged); first = end)
+	{
+		end = first + 1;
+		if (data->cfg_staged[first] == data->cfg_shadow[first])
+		{
+			continue;
+		}
+
+		// One burst for each run of changed registers
+		while (end < ARRAY_SIZE(data->cfg_staged) &&
+		       data->cfg_staged[end] != data->cfg_shadow[end])
+		{
+			end++;
+		}
+
+		ret = pcf85063a_bus_burst_write(&config->i2c, PCF85063A_CTRL1 + first,
+						&data->cfg_staged[first], end - first, __func__);
+		if (ret)
+		{
+			LOG_ERR("Unable to write RTC configuration. (err %i)", ret);
+			return ret;
+		}
+
+		memcpy(&data->cfg_shadow[first], &data->cfg_staged[first], end - first);
+	}
+
+	return 0;
 }
+#endif /* CONFIG_PCF85063A_CONFIG_CACHE */
 
+#ifdef CONFIG_PCF85063A_OFFSET
 int pcf85063a_set_offset_mode(const struct device *dev, uint8_t offset_mode_value)
 {
 	// Sets offset mode via bit 7 of Offset Register
 	// Bit 7 = 0: Normal mode - offset made every 2 hours
 	// Bit 7 = 1: Course mode - offset made every 4 minutes
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	return pcf85063a_stage(dev, PCF85063A_OFFSET, PCF85063A_OFFSET_MODE, offset_mode_value);
+#else
 	
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
 
 	uint8_t mask = PCF85063A_OFFSET_MODE;
 
 	// Write back the updated register value
-	int ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_OFFSET, mask, offset_mode_value);
+	int ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_OFFSET, mask, offset_mode_value,
+					    __func__);
 	if (ret)
 	{
 		LOG_ERR("Unable to set offset mode value. (err %i)", ret);
@@ -69,20 +185,26 @@ int pcf85063a_set_offset_mode(const struct device *dev, uint8_t offset_mode_valu
 	}
 
 	return 0;
+#endif
 }
 
 int pcf85063a_set_offset_value(const struct device *dev, uint8_t offset_value)
 {
 	// Sets offset value to enable correction for drift
 	// OFFSET[6:0] is 2's compliment of required offset value
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	return pcf85063a_stage(dev, PCF85063A_OFFSET, PCF85063A_OFFSET_VALUE_MASK, offset_value);
+#else
 		
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
 
 	uint8_t mask = PCF85063A_OFFSET_VALUE_MASK;
 
 	// Write back the updated register value
-	int ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_OFFSET, mask, offset_value);
+	int ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_OFFSET, mask, offset_value,
+					    __func__);
 	if (ret)
 	{
 		LOG_ERR("Unable to set offset value. (err %i)", ret);
@@ -90,18 +212,26 @@ int pcf85063a_set_offset_value(const struct device *dev, uint8_t offset_value)
 	}
 
 	return 0;
+#endif
 }
 
+#endif /* CONFIG_PCF85063A_OFFSET */
+
+#ifdef CONFIG_PCF85063A_CAP_SEL
 int pcf85063a_set_cap_sel(const struct device *dev, uint8_t cap_value)
 {
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	return pcf85063a_stage(dev, PCF85063A_CTRL1, PCF85063A_CTRL1_CAP_SEL, cap_value);
+#else
 
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
 
 	uint8_t mask = PCF85063A_CTRL1_CAP_SEL;
 
 	// Write back the updated register value
-	int ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_CTRL1, mask, cap_value);
+	int ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL1, mask, cap_value,
+					    __func__);
 
 	if (ret)
 	{
@@ -110,16 +240,74 @@ int pcf85063a_set_cap_sel(const struct device *dev, uint8_t cap_value)
 	}
 
 	return 0;
+#endif
 }
 
-int pcf85063a_set_time(const struct device *dev, const struct tm *time)
+#endif /* CONFIG_PCF85063A_CAP_SEL */
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+/*
+ * Publish a new anchor. Readers may run in any context and retry while the
+ * sequence count is odd, so interrupts stay off for the update.
+ */
+static void pcf85063a_store_anchor(struct pcf85063a_data *data, int64_t epoch, int64_t uptime_ticks)
+{
+	k_spinlock_key_t key = k_spin_lock(&data->anchor_lock);
+
+	data->anchor_seq++;
+	compiler_barrier();
+
+	data->anchor_epoch = epoch;
+	data->anchor_uptime_ticks = uptime_ticks;
+	data->anchor_offset_ticks = epoch * CONFIG_SYS_CLOCK_TICKS_PER_SEC - uptime_ticks;
+	data->anchor_valid = true;
+
+	compiler_barrier();
+	data->anchor_seq++;
+
+	k_spin_unlock(&data->anchor_lock, key);
+}
+
+/* Withdraw the anchor, published like a new one so readers never mix the two */
+static void pcf85063a_drop_anchor(struct pcf85063a_data *data)
 {
+	k_spinlock_key_t key = k_spin_lock(&data->anchor_lock);
+
+	data->anchor_seq++;
+	compiler_barrier();
+
+	data->anchor_valid = false;
+
+	compiler_barrier();
+	data->anchor_seq++;
 
+	k_spin_unlock(&data->anchor_lock, key);
+}
+#endif /* CONFIG_PCF85063A_ANCHOR */
+
+static int pcf85063a_write_time(const struct device *dev, const struct tm *time, const char *op)
+{
 	int ret = 0;
 
-	// Get the data pointer
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
 	struct pcf85063a_data *data = dev->data;
 
+	/* The chip counts 2000 to 2099 and does not check anything it is given */
+	if (time->tm_year < 100 || time->tm_year > 199 || time->tm_mon < 0 || time->tm_mon > 11 ||
+	    time->tm_mday < 1 ||
+	    (uint32_t)time->tm_mday > pcf85063a_days_in_month(time->tm_year + 1900, time->tm_mon + 1) ||
+	    time->tm_hour < 0 || time->tm_hour > 23 || time->tm_min < 0 || time->tm_min > 59 ||
+	    time->tm_sec < 0 || time->tm_sec > 59)
+	{
+		LOG_ERR("Invalid time.");
+		return -EINVAL;
+	}
+
+	/* Weekday alarms match on the register, so derive it rather than trust tm_wday */
+	uint32_t wday = pcf85063a_weekday(
+		pcf85063a_days_from_civil(time->tm_year + 1900, time->tm_mon + 1, time->tm_mday));
+
 	/* Set seconds */
 	uint8_t raw_time[7] = {0};
 	raw_time[0] = PCF85063A_SECONDS_MASK & (((time->tm_sec / 10) << PCF85063A_BCD_UPPER_SHIFT) + (time->tm_sec % 10));
@@ -134,52 +322,54 @@ int pcf85063a_set_time(const struct device *dev, const struct tm *time)
 	raw_time[3] = PCF85063A_DAYS_MASK & (((time->tm_mday / 10) << PCF85063A_BCD_UPPER_SHIFT) + (time->tm_mday % 10));
 
 	/* Set weekdays */
-	raw_time[4] = PCF85063A_WEEKDAYS_MASK & time->tm_wday;
+	raw_time[4] = PCF85063A_WEEKDAYS_MASK & wday;
 
-	/*Set month */
-	raw_time[5] = PCF85063A_MONTHS_MASK & (((time->tm_mon / 10) << PCF85063A_BCD_UPPER_SHIFT) + (time->tm_mon % 10));
+	/* Set month, the register counts 1 to 12 */
+	uint8_t month = time->tm_mon + 1;
+	raw_time[5] = PCF85063A_MONTHS_MASK & (((month / 10) << PCF85063A_BCD_UPPER_SHIFT) + (month % 10));
 
 	/* Set year */
 	uint8_t year = time->tm_year % 100;
 	raw_time[6] = ((year / 10) << PCF85063A_BCD_UPPER_SHIFT) + (year % 10);
 
 	/* Write to device */
-	ret = i2c_burst_write_dt(&data->i2c, PCF85063A_SECONDS,
-						  raw_time,
-						  sizeof(raw_time));
+	ret = pcf85063a_bus_burst_write(&config->i2c, PCF85063A_SECONDS, raw_time, sizeof(raw_time),
+					op);
 	if (ret)
 	{
 		LOG_ERR("Unable to set time. Err: %i", ret);
 		return ret;
 	}
 
+#ifdef CONFIG_PCF85063A_ANCHOR
+	/* The write restarts the prescaler, the old edge anchor is stale */
+	pcf85063a_drop_anchor(data);
+#endif
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	data->subsec_calibrated = false;
+#endif
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+	data->writes++;
+#endif
+#ifdef CONFIG_PCF85063A_FATTIME
+	data->fat_valid = false;
+#endif
+#ifdef CONFIG_PCF85063A_HEALTH
+	/* Time jumped on purpose, start a new comparison window */
+	data->health_seen = false;
+#endif
+	ARG_UNUSED(data);
+
 	return 0;
 }
 
-int pcf85063a_get_time(const struct device *dev, struct tm *time)
+int pcf85063a_set_time(const struct device *dev, const struct tm *time)
 {
-	int ret = 0;
-	uint8_t raw_time[7] = {0};
-
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
-
-	ret = i2c_burst_read_dt(&data->i2c, PCF85063A_SECONDS,
-						 raw_time,
-						 sizeof(raw_time));
-	if (ret)
-	{
-		LOG_ERR("Unable to get time. Err: %i", ret);
-		return ret;
-	}
-
-	/* Make sure the time is set properly.. */
-	if (raw_time[0] & PCF85063A_SECONDS_OS)
-	{
-		LOG_WRN("Clock integrity error.");
-		return -EIO;
-	}
+	return pcf85063a_write_time(dev, time, __func__);
+}
 
+static void pcf85063a_decode_time(const uint8_t *raw_time, struct tm *time)
+{
 	/* Get seconds */
 	time->tm_sec = (raw_time[0] & PCF85063A_BCD_LOWER_MASK) + (((raw_time[0] & PCF85063A_BCD_UPPER_MASK_SEC) >> PCF85063A_BCD_UPPER_SHIFT) * 10);
 
@@ -195,235 +385,1817 @@ int pcf85063a_get_time(const struct device *dev, struct tm *time)
 	/* Get weekdays */
 	time->tm_wday = (raw_time[4] & PCF85063A_BCD_LOWER_MASK) + (((raw_time[4] & PCF85063A_BCD_UPPER_MASK) >> PCF85063A_BCD_UPPER_SHIFT) * 10);
 
-	/* Get month */
-	time->tm_mon = (raw_time[5] & PCF85063A_BCD_LOWER_MASK) + (((raw_time[5] & PCF85063A_BCD_UPPER_MASK) >> PCF85063A_BCD_UPPER_SHIFT) * 10);
+	/* Get month, 1 to 12 in the register */
+	time->tm_mon = (raw_time[5] & PCF85063A_BCD_LOWER_MASK) + (((raw_time[5] & PCF85063A_BCD_UPPER_MASK) >> PCF85063A_BCD_UPPER_SHIFT) * 10) - 1;
 
 	/* Get year with offset of 100 since we're in 2000+ */
 	time->tm_year = (raw_time[6] & PCF85063A_BCD_LOWER_MASK) + (((raw_time[6] & PCF85063A_BCD_UPPER_MASK) >> PCF85063A_BCD_UPPER_SHIFT) * 10) + 100;
 
-	/* Get day number in year */
-	time->tm_yday = get_yday(time->tm_mon, time->tm_mday, time->tm_year + 1900);
+	/* Get day number in year. Registers that are not a valid date still give some number. */
+	time->tm_yday = pcf85063a_yday(time->tm_year + 1900, time->tm_mon + 1, time->tm_mday);
 
 	/* DST not used  */
 	time->tm_isdst = 0;
-
-	return 0;
 }
 
-static int pcf85063a_start(const struct device *dev)
+#ifdef CONFIG_PCF85063A_HEALTH
+static void pcf85063a_set_health(const struct device *dev, enum pcf85063a_health health)
 {
-
-	// Get the data pointer
 	struct pcf85063a_data *data = dev->data;
+	pcf85063a_health_callback_t callback = data->health_callback;
 
-	// Turn it back on (active low)
-	uint8_t reg = 0;
-	uint8_t mask = PCF85063A_CTRL1_STOP;
+	if (data->health == health)
+	{
+		return;
+	}
 
-	// Write back the updated register value
-	int ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_CTRL1, mask, reg);
-	if (ret)
+	if (health != PCF85063A_HEALTH_OK)
 	{
-		LOG_ERR("Unable to stop RTC. (err %i)", ret);
-		return ret;
+		LOG_WRN("Health %d, was %d.", health, data->health);
 	}
 
-	return 0;
+	data->health = health;
+
+	if (callback)
+	{
+		callback(dev, health, data->health_user_data);
+	}
 }
 
-static int pcf85063a_stop(const struct device *dev)
+static bool pcf85063a_bcd_valid(uint8_t value, uint8_t min, uint8_t max)
 {
+	if ((value & PCF85063A_BCD_LOWER_MASK) > 9 || (value >> PCF85063A_BCD_UPPER_SHIFT) > 9)
+	{
+		return false;
+	}
 
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
+	return bcd2bin(value) >= min && bcd2bin(value) <= max;
+}
 
-	// Turn it off
-	uint8_t reg = PCF85063A_CTRL1_STOP;
-	uint8_t mask = PCF85063A_CTRL1_STOP;
+/*
+ * Judge the clock from a time register read the driver made anyway: an
+ * idle bus reads back as all ones, registers must hold in-range BCD, and
+ * over at least CONFIG_PCF85063A_HEALTH_WINDOW_S of uptime the seconds must
+ * have moved along with it.
+ */
+static void pcf85063a_health_observe(const struct device *dev, const uint8_t *raw_time, int ret)
+{
+	struct pcf85063a_data *data = dev->data;
+	int64_t now = k_uptime_get();
+	int64_t elapsed_ms, rtc_ms, tolerance_ms;
+	struct tm time;
+	int64_t epoch;
+	bool ones = true;
 
-	// Write back the updated register value
-	int ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_CTRL1, mask, reg);
 	if (ret)
 	{
-		LOG_ERR("Unable to stop RTC. (err %i)", ret);
-		return ret;
+		if (++data->bus_errors >= CONFIG_PCF85063A_HEALTH_BUS_ERRORS)
+		{
+			pcf85063a_set_health(dev, PCF85063A_HEALTH_BUS_STUCK);
+		}
+		return;
 	}
 
-	return 0;
-}
-
-static int pcf85063a_get_value(const struct device *dev, uint32_t *ticks)
-{
-	return 0;
-}
+	data->bus_errors = 0;
 
-static int pcf85063a_set_alarm(
-	const struct device *dev, uint8_t chan_id, const struct counter_alarm_cfg *alarm_cfg)
-{
-	ARG_UNUSED(chan_id);
+	for (int i = 0; i < 7; i++)
+	{
+		ones &= raw_time[i] == 0xff;
+	}
 
-	uint8_t ticks = (uint8_t)alarm_cfg->ticks;
+	if (ones)
+	{
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_BUS_STUCK);
+		return;
+	}
 
-	// Get the data pointer
-	struct pcf85063a_data *data = dev->data;
+	if (raw_time[0] & PCF85063A_SECONDS_OS)
+	{
+		data->health_seen = false;
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_OSC_STOPPED);
+		return;
+	}
 
-	// Ret val for error checking
-	int ret;
+	if (!pcf85063a_bcd_valid(raw_time[0] & PCF85063A_SECONDS_MASK, 0, 59) ||
+	    !pcf85063a_bcd_valid(raw_time[1] & PCF85063A_MINUTES_MASK, 0, 59) ||
+	    !pcf85063a_bcd_valid(raw_time[2] & PCF85063A_HOURS_MASK, 0, 23) ||
+	    !pcf85063a_bcd_valid(raw_time[3] & PCF85063A_DAYS_MASK, 1, 31) ||
+	    (raw_time[4] & PCF85063A_WEEKDAYS_MASK) > 6 ||
+	    !pcf85063a_bcd_valid(raw_time[5] & PCF85063A_MONTHS_MASK, 1, 12) ||
+	    !pcf85063a_bcd_valid(raw_time[6], 0, 99))
+	{
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_IMPLAUSIBLE);
+		return;
+	}
 
-	// Clear any flags in CTRL2
-	uint8_t reg = 0;
-	uint8_t mask = PCF85063A_CTRL2_TF;
+	pcf85063a_decode_time(raw_time, &time);
+	epoch = timeutil_timegm64(&time);
 
-	ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_CTRL2, mask, reg);
-	if (ret)
+	if (!data->health_seen)
 	{
-		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
-		return ret;
+		data->health_epoch = epoch;
+		data->health_uptime_ms = now;
+		data->health_seen = true;
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_OK);
+		return;
 	}
 
-	// Write the tick count. Ticks are 1 sec
-	ret = i2c_reg_write_byte_dt(&data->i2c, PCF85063A_TIMER_VALUE, ticks);
-	if (ret)
+	elapsed_ms = now - data->health_uptime_ms;
+	if (elapsed_ms < (int64_t)CONFIG_PCF85063A_HEALTH_WINDOW_S * MSEC_PER_SEC)
 	{
-		LOG_ERR("Unable to set RTC timer value. (err %i)", ret);
-		return ret;
+		return;
 	}
 
-	// Set to 1 second mode
-	reg = (PCF85063A_TIMER_MODE_FREQ_1 << PCF85063A_TIMER_MODE_FREQ_SHIFT) | PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN;
-	mask = PCF85063A_TIMER_MODE_FREQ_MASK | PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN;
+	// Both ends of the RTC interval are whole seconds, allow for that
+	rtc_ms = (epoch - data->health_epoch) * MSEC_PER_SEC;
+	tolerance_ms = CONFIG_PCF85063A_HEALTH_TOLERANCE_MS + elapsed_ms / 1000;
 
-	LOG_INF("mode 0x%x", reg);
+	data->health_epoch = epoch;
+	data->health_uptime_ms = now;
 
-	// Write back the updated register value
-	ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_TIMER_MODE, mask, reg);
-	if (ret)
+	if (rtc_ms == 0)
 	{
-		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
-		return ret;
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_OSC_STUCK);
+	}
+	else if (rtc_ms - elapsed_ms > tolerance_ms || elapsed_ms - rtc_ms > tolerance_ms)
+	{
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_TIME_SKEW);
+	}
+	else
+	{
+		pcf85063a_set_health(dev, PCF85063A_HEALTH_OK);
 	}
-
-	return 0;
 }
 
-static int pcf85063a_cancel_alarm(const struct device *dev, uint8_t chan_id)
+enum pcf85063a_health pcf85063a_get_health(const struct device *dev)
 {
+	struct pcf85063a_data *data = dev->data;
+
+	return data->health;
+}
 
-	// Get the data pointer
+void pcf85063a_set_health_callback(const struct device *dev, pcf85063a_health_callback_t callback,
+				   void *user_data)
+{
 	struct pcf85063a_data *data = dev->data;
 
-	// Ret val for error checking
-	int ret;
+	data->health_user_data = user_data;
+	data->health_callback = callback;
+}
+#endif /* CONFIG_PCF85063A_HEALTH */
 
-	// Clear any flags in CTRL2
-	uint8_t reg = 0;
-	uint8_t mask = PCF85063A_CTRL2_TF;
+int pcf85063a_get_time(const struct device *dev, struct tm *time)
+{
+	int ret = 0;
+	uint8_t raw_time[7] = {0};
+
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
 
-	ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_CTRL2, mask, reg);
+	ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_SECONDS, raw_time, sizeof(raw_time),
+				       __func__);
+#ifdef CONFIG_PCF85063A_HEALTH
+	pcf85063a_health_observe(dev, raw_time, ret);
+#endif
 	if (ret)
 	{
-		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
+		LOG_ERR("Unable to get time. Err: %i", ret);
 		return ret;
 	}
 
-	// Turn off all itnerrupts/timer mode
-	reg = 0;
-	mask = PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN | PCF85063A_TIMER_MODE_INT_TI_TP;
-
-	LOG_INF("mode 0x%x", reg);
-
-	// Write back the updated register value
-	ret = i2c_reg_update_byte_dt(&data->i2c, PCF85063A_TIMER_MODE, mask, reg);
-	if (ret)
+	/* Make sure the time is set properly.. */
+	if (raw_time[0] & PCF85063A_SECONDS_OS)
 	{
-		LOG_ERR("Unable to cancel RTC alarm. (err %i)", ret);
-		return ret;
+		LOG_WRN("Clock integrity error.");
+		return -EIO;
 	}
 
-	return 0;
-}
+	pcf85063a_decode_time(raw_time, time);
 
-static int pcf85063a_set_top_value(const struct device *dev, const struct counter_top_cfg *cfg)
-{
 	return 0;
 }
 
-static uint32_t pcf85063a_get_pending_int(const struct device *dev)
+#ifdef CONFIG_PCF85063A_ANCHOR
+/*
+ * Find the uptime at which the seconds register last incremented and store
+ * it, together with the RTC time it incremented to, as the edge anchor.
+ *
+ * A recent anchor already knows the phase of the seconds counter relative to
+ * uptime, so a single burst read that lands inside the predicted second
+ * confirms it and the measured anchor is kept, age included. Otherwise, once
+ * the anchor is CONFIG_PCF85063A_ANCHOR_MAX_AGE_S old, or when measure asks
+ * for a fresh edge, the seconds register is polled until it rolls over.
+ */
+static int pcf85063a_capture_edge(const struct device *dev, bool measure, const char *op)
 {
-
-	// Get the data pointer
+	const struct pcf85063a_config *config = dev->config;
 	struct pcf85063a_data *data = dev->data;
+	uint8_t raw_time[7] = {0};
+	uint8_t seconds;
+	struct tm time;
+	int64_t epoch;
+	int64_t before, after, last_before, deadline;
+	int ret;
 
-	// Start with 0
-	uint8_t reg = 0;
-
-	// Write back the updated register value
-	int ret = i2c_reg_read_byte_dt(&data->i2c, PCF85063A_CTRL2, &reg);
+	before = k_uptime_ticks();
+	ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_SECONDS, raw_time, sizeof(raw_time),
+				       op);
+	after = k_uptime_ticks();
+#ifdef CONFIG_PCF85063A_HEALTH
+	pcf85063a_health_observe(dev, raw_time, ret);
+#endif
 	if (ret)
 	{
-		LOG_ERR("Unable to get RTC CTRL2 reg. (err %i)", ret);
+		LOG_ERR("Unable to get time. Err: %i", ret);
 		return ret;
 	}
 
-	// Return 1 if interrupt. 0 if no flag.
-	return (reg & PCF85063A_CTRL2_TF) ? 1U : 0U;
+	/* Time has never been set, there is no edge worth comparing against */
+	if (raw_time[0] & PCF85063A_SECONDS_OS)
+	{
+		return -ENODATA;
+	}
+
+	pcf85063a_decode_time(raw_time, &time);
+	epoch = timeutil_timegm64(&time);
+
+	if (!measure && data->anchor_valid &&
+	    after - data->anchor_uptime_ticks <
+		    (int64_t)CONFIG_PCF85063A_ANCHOR_MAX_AGE_S * CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+	{
+		int64_t edge = data->anchor_uptime_ticks +
+			       (epoch - data->anchor_epoch) * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+
+		// Only an extrapolation, storing it would reset the age unmeasured
+		if (edge <= before && after < edge + CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+		{
+			return 0;
+		}
+	}
+
+	/* Poll until the seconds register rolls over. Bounded to a bit more than a second. */
+	last_before = before;
+	deadline = after + CONFIG_SYS_CLOCK_TICKS_PER_SEC + CONFIG_SYS_CLOCK_TICKS_PER_SEC / 10;
+
+	do
+	{
+		k_msleep(CONFIG_PCF85063A_EDGE_POLL_MS);
+
+		before = k_uptime_ticks();
+		ret = pcf85063a_bus_read_byte(&config->i2c, PCF85063A_SECONDS, &seconds, op);
+		after = k_uptime_ticks();
+		if (ret)
+		{
+			LOG_ERR("Unable to get seconds. Err: %i", ret);
+			return ret;
+		}
+
+		if (seconds != raw_time[0])
+		{
+			/* The edge happened between the last stale read and this one */
+			pcf85063a_store_anchor(data, epoch + 1, last_before + (after - last_before) / 2);
+			return 0;
+		}
+
+		last_before = before;
+	} while (after < deadline);
+
+	LOG_WRN("Seconds register did not advance.");
+	pcf85063a_drop_anchor(data);
+#ifdef CONFIG_PCF85063A_HEALTH
+	pcf85063a_set_health(dev, PCF85063A_HEALTH_OSC_STUCK);
+#endif
+
+	return -ETIMEDOUT;
 }
 
-static uint32_t pcf85063a_get_top_value(const struct device *dev)
+int pcf85063a_sync_anchor(const struct device *dev)
 {
-	return 0;
+	return pcf85063a_capture_edge(dev, false, __func__);
 }
 
-static const struct counter_driver_api pcf85063a_api = {
-	.start = pcf85063a_start,
-	.stop = pcf85063a_stop,
-	.get_value = pcf85063a_get_value,
-	.set_alarm = pcf85063a_set_alarm,
-	.cancel_alarm = pcf85063a_cancel_alarm,
-	.set_top_value = pcf85063a_set_top_value,
-	.get_pending_int = pcf85063a_get_pending_int,
-	.get_top_value = pcf85063a_get_top_value,
-};
-
-int pcf85063a_init(const struct device *dev)
+int pcf85063a_get_anchor(const struct device *dev, struct pcf85063a_anchor *anchor)
 {
+	struct pcf85063a_data *data = dev->data;
+	uint32_t seq;
+	bool valid;
 
-	/* Get the i2c device binding*/
+	do
+	{
+		seq = data->anchor_seq;
+		compiler_barrier();
+		valid = data->anchor_valid;
+		anchor->epoch = data->anchor_epoch;
+		anchor->uptime_ticks = data->anchor_uptime_ticks;
+		compiler_barrier();
+	} while ((seq & 1) || seq != data->anchor_seq);
+
+	return valid ? 0 : -EAGAIN;
+}
+
+int pcf85063a_get_realtime_ticks(const struct device *dev, int64_t *ticks)
+{
 	struct pcf85063a_data *data = dev->data;
-	/* Set I2C Device. */
-	if (!device_is_ready(data->i2c.bus))
+	uint32_t seq;
+	int64_t offset;
+	bool valid;
+
+	do
 	{
-		LOG_ERR("Failed to get pointer to %s device!", data->i2c.bus->name);
-		return -EINVAL;
+		seq = data->anchor_seq;
+		compiler_barrier();
+		valid = data->anchor_valid;
+		offset = data->anchor_offset_ticks;
+		compiler_barrier();
+	} while ((seq & 1) || seq != data->anchor_seq);
+
+	if (!valid)
+	{
+		return -EAGAIN;
 	}
 
-	/* Check if it's alive. */
-	uint8_t reg;
-	int ret = i2c_reg_read_byte_dt(&data->i2c, PCF85063A_CTRL1, &reg);
+	*ticks = k_uptime_ticks() + offset;
+
+	return 0;
+}
+
+#endif /* CONFIG_PCF85063A_ANCHOR */
+
+#ifdef CONFIG_PCF85063A_SUBSECOND
+/*
+ * 4096 is a whole number of 128 tick periods, so every second starts at the
+ * same countdown phase. Only the period within the second is left to find.
+ */
+#define PCF85063A_SUBSEC_HZ 4096
+#define PCF85063A_SUBSEC_RELOAD 128
+#define PCF85063A_SUBSEC_PERIODS (PCF85063A_SUBSEC_HZ / PCF85063A_SUBSEC_RELOAD)
+
+/* SECONDS through TIMER_VALUE are contiguous, one burst latches both */
+#define PCF85063A_SUBSEC_BURST_LEN (PCF85063A_TIMER_VALUE - PCF85063A_SECONDS + 1)
+
+/* Polling window either side of the predicted edge while calibrating */
+#define PCF85063A_SUBSEC_GUARD_MS 5
+
+/* 100 s at 100 ppm of MCU clock error is 10 ms, within half a 1/32 s period */
+#define PCF85063A_SUBSEC_MAX_AGE_S 100
+
+/* Picking the period needs uptime to better than half of one, 15 ms */
+BUILD_ASSERT(CONFIG_SYS_CLOCK_TICKS_PER_SEC >= 4 * PCF85063A_SUBSEC_PERIODS,
+	     "Kernel tick too coarse for the fractional second counter");
+
+/* Ticks into the current period. The value reads 0 or the reload at the wrap. */
+static uint8_t pcf85063a_subsec_phase(uint8_t value)
+{
+	return (PCF85063A_SUBSEC_RELOAD - value) % PCF85063A_SUBSEC_RELOAD;
+}
+
+static int pcf85063a_subsec_read(const struct device *dev, uint8_t *raw, int64_t *uptime_ticks,
+				 const char *op)
+{
+	const struct pcf85063a_config *config = dev->config;
+	int ret;
+
+	*uptime_ticks = k_uptime_ticks();
+	ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_SECONDS, raw,
+				       PCF85063A_SUBSEC_BURST_LEN, op);
+#ifdef CONFIG_PCF85063A_HEALTH
+	pcf85063a_health_observe(dev, raw, ret);
+#endif
+	if (ret)
+	{
+		LOG_ERR("Unable to get time. Err: %i", ret);
+		return ret;
+	}
+
+	if (raw[0] & PCF85063A_SECONDS_OS)
+	{
+		return -ENODATA;
+	}
+
+	return 0;
+}
+
+/*
+ * Find the countdown phase at which the seconds register increments. Both
+ * run off the same prescaler, so it holds until the time is written. Bursts
+ * are issued back to back around the edge the anchor predicts, the phases
+ * read either side of the increment bracket it.
+ *
+ * Each burst latches the seconds first and reaches TIMER_VALUE a fixed
+ * number of bytes later. That lag is in the stored phase and in every later
+ * read alike, so it cancels.
+ */
+static int pcf85063a_subsec_calibrate(const struct device *dev, const char *op)
+{
+	struct pcf85063a_data *data = dev->data;
+	uint8_t prev[PCF85063A_SUBSEC_BURST_LEN], cur[PCF85063A_SUBSEC_BURST_LEN];
+	int64_t guard = k_ms_to_ticks_ceil64(PCF85063A_SUBSEC_GUARD_MS);
+	int64_t prev_uptime, uptime, edge;
+	uint16_t before, after;
+	int ret;
+
+	// The prediction below must hold within the guard, so measure the edge
+	ret = pcf85063a_capture_edge(dev, true, op);
+	if (ret)
+	{
+		return ret;
+	}
+
+	// Next predicted edge at least a guard interval away
+	uptime = k_uptime_ticks();
+	edge = data->anchor_uptime_ticks +
+	       ((uptime - data->anchor_uptime_ticks) / CONFIG_SYS_CLOCK_TICKS_PER_SEC + 1) *
+		       CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	if (edge - uptime < guard)
+	{
+		edge += CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	}
+
+	k_sleep(K_TICKS(edge - guard - uptime));
+
+	ret = pcf85063a_subsec_read(dev, prev, &prev_uptime, op);
+	if (ret)
+	{
+		return ret;
+	}
+
+	do
+	{
+		ret = pcf85063a_subsec_read(dev, cur, &uptime, op);
+		if (ret)
+		{
+			return ret;
+		}
+
+		if (cur[0] != prev[0])
+		{
+			// A gap of a whole period or more leaves the bracket ambiguous
+			if (uptime - prev_uptime >=
+			    CONFIG_SYS_CLOCK_TICKS_PER_SEC / PCF85063A_SUBSEC_PERIODS)
+			{
+				return -EAGAIN;
+			}
+
+			before = pcf85063a_subsec_phase(prev[PCF85063A_SUBSEC_BURST_LEN - 1]);
+			after = pcf85063a_subsec_phase(cur[PCF85063A_SUBSEC_BURST_LEN - 1]);
+			if (after < before)
+			{
+				after += PCF85063A_SUBSEC_RELOAD;
+			}
+
+			data->subsec_edge_phase = ((before + after + 1) / 2) % PCF85063A_SUBSEC_RELOAD;
+			data->subsec_calibrated = true;
+
+			LOG_DBG("Seconds edge at timer phase %u (+/- %u).", data->subsec_edge_phase,
+				(after - before + 1) / 2);
+			return 0;
+		}
+
+		memcpy(prev, cur, sizeof(prev));
+		prev_uptime = uptime;
+	} while (uptime < edge + guard);
+
+	LOG_WRN("Seconds edge not where the anchor put it.");
+	pcf85063a_drop_anchor(data);
+
+	return -ETIMEDOUT;
+}
+
+int pcf85063a_subsec_start(const struct device *dev)
+{
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
+
+#ifdef CONFIG_PCF85063A_ALARM
+	if (data->alarm_armed || data->periodic_callback)
+	{
+		return -EBUSY;
+	}
+#endif
+
+	ret = pcf85063a_bus_write_byte(&config->i2c, PCF85063A_TIMER_VALUE, PCF85063A_SUBSEC_RELOAD,
+				       __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to set RTC timer value. (err %i)", ret);
+		return ret;
+	}
+
+	// 4096 Hz, running, no interrupt. TF still sets every period and is ignored.
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_TIMER_MODE,
+					PCF85063A_TIMER_MODE_FREQ_MASK | PCF85063A_TIMER_MODE_EN |
+						PCF85063A_TIMER_MODE_INT_EN |
+						PCF85063A_TIMER_MODE_INT_TI_TP,
+					(PCF85063A_TIMER_MODE_FREQ_4K << PCF85063A_TIMER_MODE_FREQ_SHIFT) |
+						PCF85063A_TIMER_MODE_EN,
+					__func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to start RTC timer. (err %i)", ret);
+		return ret;
+	}
+
+	data->subsec_running = true;
+	data->subsec_calibrated = false;
+
+	return pcf85063a_subsec_calibrate(dev, __func__);
+}
+
+int pcf85063a_subsec_stop(const struct device *dev)
+{
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
+
+	if (!data->subsec_running)
+	{
+		return 0;
+	}
+
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_TIMER_MODE, PCF85063A_TIMER_MODE_EN,
+					0, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to stop RTC timer. (err %i)", ret);
+		return ret;
+	}
+
+	// Drop the stale TF so the alarm path starts clean
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2, PCF85063A_CTRL2_TF, 0,
+					__func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to clear RTC timer flag. (err %i)", ret);
+		return ret;
+	}
+
+	data->subsec_running = false;
+	data->subsec_calibrated = false;
+
+	return 0;
+}
+
+int pcf85063a_subsec_get(const struct device *dev, struct timespec *ts)
+{
+	struct pcf85063a_data *data = dev->data;
+	uint8_t raw[PCF85063A_SUBSEC_BURST_LEN];
+	struct tm time;
+	int64_t epoch, uptime, edge, coarse, period;
+	uint16_t fine, ticks;
+	int ret;
+
+	if (!data->subsec_running)
+	{
+		return -EAGAIN;
+	}
+
+	// A time write moved the seconds against the timer
+	if (!data->subsec_calibrated)
+	{
+		ret = pcf85063a_subsec_calibrate(dev, __func__);
+		if (ret)
+		{
+			return ret;
+		}
+	}
+
+	// Half a period of drift picks the wrong one, re-measure well before
+	if (!data->anchor_valid ||
+	    k_uptime_ticks() - data->anchor_uptime_ticks >=
+		    (int64_t)MIN(CONFIG_PCF85063A_ANCHOR_MAX_AGE_S, PCF85063A_SUBSEC_MAX_AGE_S) *
+			    CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+	{
+		ret = pcf85063a_capture_edge(dev, true, __func__);
+		if (ret)
+		{
+			return ret;
+		}
+	}
+
+	ret = pcf85063a_subsec_read(dev, raw, &uptime, __func__);
+	if (ret)
+	{
+		return ret;
+	}
+
+	pcf85063a_decode_time(raw, &time);
+	epoch = timeutil_timegm64(&time);
+
+	// Position inside the period, measured from the seconds edge
+	fine = (pcf85063a_subsec_phase(raw[PCF85063A_SUBSEC_BURST_LEN - 1]) + PCF85063A_SUBSEC_RELOAD -
+		data->subsec_edge_phase) %
+	       PCF85063A_SUBSEC_RELOAD;
+
+	// Which period, from uptime since the anchored edge of this second. The
+	// seconds and the value come from the same burst, so no rollover can
+	// fall between them and the period is never past the last one.
+	edge = data->anchor_uptime_ticks + (epoch - data->anchor_epoch) * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	coarse = (uptime - edge) * PCF85063A_SUBSEC_HZ / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	period = coarse - fine + PCF85063A_SUBSEC_RELOAD / 2;
+	period = period < 0 ? 0 : MIN(period / PCF85063A_SUBSEC_RELOAD, PCF85063A_SUBSEC_PERIODS - 1);
+	ticks = fine + period * PCF85063A_SUBSEC_RELOAD;
+
+	// The resolved position is finer than any polled edge, keep the anchor on it
+	pcf85063a_store_anchor(data, epoch,
+			       uptime - (int64_t)ticks * CONFIG_SYS_CLOCK_TICKS_PER_SEC /
+						PCF85063A_SUBSEC_HZ);
+
+	ts->tv_sec = epoch;
+	ts->tv_nsec = (int64_t)ticks * NSEC_PER_SEC / PCF85063A_SUBSEC_HZ;
+
+	return 0;
+}
+#endif /* CONFIG_PCF85063A_SUBSECOND */
+
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+/*
+ * Fold an offset observed against a reference into the drift estimate. Offsets
+ * larger than the crystal could plausibly accumulate are steps, not drift.
+ */
+static void pcf85063a_update_drift(struct pcf85063a_data *data, int64_t offset_ms, int64_t now_ms)
+{
+	int64_t elapsed_ms = now_ms - data->sync_uptime_ms;
+	int32_t sample_ppb;
+
+	if (!data->synced || elapsed_ms < (int64_t)CONFIG_PCF85063A_DRIFT_MIN_INTERVAL_S * MSEC_PER_SEC)
+	{
+		return;
+	}
+
+	if (offset_ms > elapsed_ms / 1000 || offset_ms < -elapsed_ms / 1000)
+	{
+		LOG_DBG("Offset %lld ms over %lld ms is a step, not drift.", offset_ms, elapsed_ms);
+		return;
+	}
+
+	/* Positive when the RTC runs fast compared to the reference */
+	sample_ppb = (int32_t)(-offset_ms * 1000000000LL / elapsed_ms);
+
+	if (!data->drift_valid)
+	{
+		data->drift_ppb = sample_ppb;
+		data->drift_valid = true;
+	}
+	else
+	{
+		data->drift_ppb += (sample_ppb - data->drift_ppb) / 4;
+	}
+}
+
+/*
+ * Write the reference to the RTC on the reference's own second boundary so
+ * the new prescaler phase lines up with it.
+ */
+static int pcf85063a_write_reference(const struct device *dev,
+				     const struct pcf85063a_reference *ref, const char *op)
+{
+	struct pcf85063a_data *data = dev->data;
+	int64_t now_ms = ref->epoch_ms + (k_uptime_get() - ref->uptime_ms);
+	int32_t wait_ms = MSEC_PER_SEC - (int32_t)(now_ms % MSEC_PER_SEC);
+	time_t epoch = (time_t)((now_ms + wait_ms) / MSEC_PER_SEC);
+	struct tm time;
+	int ret;
+
+	k_msleep(wait_ms);
+
+	gmtime_r(&epoch, &time);
+
+	ret = pcf85063a_write_time(dev, &time, op);
+	if (ret)
+	{
+		return ret;
+	}
+
+	data->sync_uptime_ms = k_uptime_get();
+	data->synced = true;
+
+	return 0;
+}
+
+int pcf85063a_ingest_reference(const struct device *dev, const struct pcf85063a_reference *ref)
+{
+	struct pcf85063a_data *data = dev->data;
+	int64_t edge_ms, offset_ms;
+	int ret;
+
+	data->references++;
+
+	// The comparison needs this edge, not one extrapolated from an old one
+	ret = pcf85063a_capture_edge(dev, true, __func__);
+	if (ret == -ENODATA)
+	{
+		/* Nothing to compare against, the RTC needs the time regardless */
+		return pcf85063a_write_reference(dev, ref, __func__);
+	}
+	else if (ret)
+	{
+		return ret;
+	}
+
+	/* Project the reference onto the edge and compare */
+	edge_ms = k_ticks_to_ms_floor64(data->anchor_uptime_ticks);
+	offset_ms = ref->epoch_ms + (edge_ms - ref->uptime_ms) - data->anchor_epoch * MSEC_PER_SEC;
+	data->last_offset_ms = (int32_t)CLAMP(offset_ms, INT32_MIN, INT32_MAX);
+
+	if (offset_ms <= (int64_t)CONFIG_PCF85063A_SYNC_TOLERANCE_MS + ref->uncertainty_ms &&
+	    offset_ms >= -((int64_t)CONFIG_PCF85063A_SYNC_TOLERANCE_MS + ref->uncertainty_ms))
+	{
+		LOG_DBG("Offset %lld ms within tolerance, skipping write.", offset_ms);
+		data->suppressed++;
+		return 0;
+	}
+
+	LOG_DBG("Offset %lld ms, writing reference.", offset_ms);
+	pcf85063a_update_drift(data, offset_ms, edge_ms);
+
+	return pcf85063a_write_reference(dev, ref, __func__);
+}
+
+int pcf85063a_get_sync_stats(const struct device *dev, struct pcf85063a_sync_stats *stats)
+{
+	struct pcf85063a_data *data = dev->data;
+	int64_t uptime_ms = MAX(k_uptime_get(), 1);
+
+	stats->references = data->references;
+	stats->suppressed = data->suppressed;
+	stats->writes = data->writes;
+	stats->writes_per_day = (uint32_t)(data->writes * 86400000LL / uptime_ms);
+	stats->last_offset_ms = data->last_offset_ms;
+	stats->drift_ppb = data->drift_valid ? data->drift_ppb : 0;
+
+	return 0;
+}
+
+#endif /* CONFIG_PCF85063A_REFERENCE_SYNC */
+
+#ifdef CONFIG_PCF85063A_FATTIME
+/* Pack the BCD time registers straight into a FAT date/time word */
+static uint32_t pcf85063a_raw_to_fattime(const uint8_t *raw_time)
+{
+	uint32_t year = bcd2bin(raw_time[6]) + 20;
+	uint32_t month = bcd2bin(raw_time[5] & PCF85063A_MONTHS_MASK);
+	uint32_t day = bcd2bin(raw_time[3] & PCF85063A_DAYS_MASK);
+	uint32_t hour = bcd2bin(raw_time[2] & PCF85063A_HOURS_MASK);
+	uint32_t min = bcd2bin(raw_time[1] & PCF85063A_MINUTES_MASK);
+	uint32_t sec = bcd2bin(raw_time[0] & PCF85063A_SECONDS_MASK);
+
+	return (year << 25) | (month << 21) | (day << 16) | (hour << 11) | (min << 5) | (sec >> 1);
+}
+
+int pcf85063a_get_fattime(const struct device *dev, uint32_t *fattime)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	uint8_t raw_time[7];
+	int64_t now = k_uptime_get();
+	k_spinlock_key_t key;
+	int ret;
+
+	/*
+	 * Within the minute of the last read only the seconds field moves, so
+	 * advance it by uptime. The read landed somewhere inside its second, so
+	 * this may lag the RTC by up to a second, below FAT's 2 s resolution.
+	 */
+	key = k_spin_lock(&data->fat_lock);
+	if (data->fat_valid)
+	{
+		int64_t sec = data->fat_sec + (now - data->fat_uptime_ms) / MSEC_PER_SEC;
+
+		if (sec < 60)
+		{
+			*fattime = (data->fat_base & ~0x1fU) | (uint32_t)(sec >> 1);
+			k_spin_unlock(&data->fat_lock, key);
+			return 0;
+		}
+	}
+	k_spin_unlock(&data->fat_lock, key);
+
+	ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_SECONDS, raw_time, sizeof(raw_time),
+				       __func__);
+#ifdef CONFIG_PCF85063A_HEALTH
+	pcf85063a_health_observe(dev, raw_time, ret);
+#endif
+	if (ret)
+	{
+		LOG_ERR("Unable to get time. Err: %i", ret);
+		return ret;
+	}
+
+	if (raw_time[0] & PCF85063A_SECONDS_OS)
+	{
+		return -EIO;
+	}
+
+	key = k_spin_lock(&data->fat_lock);
+	data->fat_base = pcf85063a_raw_to_fattime(raw_time);
+	data->fat_sec = bcd2bin(raw_time[0] & PCF85063A_SECONDS_MASK);
+	data->fat_uptime_ms = now;
+	data->fat_valid = true;
+	*fattime = data->fat_base;
+	k_spin_unlock(&data->fat_lock, key);
+
+	return 0;
+}
+
+#ifdef CONFIG_PCF85063A_FATFS_GET_FATTIME
+DWORD get_fattime(void)
+{
+	uint32_t fattime;
+
+	/* FatFs has no error path here, 0 leaves the timestamp blank */
+	if (pcf85063a_get_fattime(DEVICE_DT_GET_ONE(nxp_pcf85063a), &fattime))
+	{
+		return 0;
+	}
+
+	return fattime;
+}
+#endif /* CONFIG_PCF85063A_FATFS_GET_FATTIME */
+#endif /* CONFIG_PCF85063A_FATTIME */
+
+#ifdef CONFIG_PCF85063A_FACTORY_RESET
+/* CLKOUT frequencies in Hz, indexed by COF */
+static const uint16_t pcf85063a_clkout_hz[] = {
+	[PCF85063A_CTRL2_COF_32K] = 32768, [PCF85063A_CTRL2_COF_16K] = 16384,
+	[PCF85063A_CTRL2_COF_8K] = 8192,   [PCF85063A_CTRL2_COF_4K] = 4096,
+	[PCF85063A_CTRL2_COF_2K] = 2048,   [PCF85063A_CTRL2_COF_1K] = 1024,
+	[PCF85063A_CTRL2_COF_1] = 1,	   [PCF85063A_CTRL2_COF_LOW] = 0,
+};
+
+static uint8_t pcf85063a_clkout_cof(uint32_t hz)
+{
+#ifdef CONFIG_PCF85063A_CLKOUT_TIMER
+	/* The kernel runs off CLKOUT */
+	ARG_UNUSED(hz);
+	return PCF85063A_CTRL2_COF_32K;
+#else
+	for (int i = 0; i < ARRAY_SIZE(pcf85063a_clkout_hz); i++)
+	{
+		if (pcf85063a_clkout_hz[i] == hz)
+		{
+			return i;
+		}
+	}
+
+	LOG_WRN("No CLKOUT of %u Hz, leaving it off.", hz);
+	return PCF85063A_CTRL2_COF_LOW;
+#endif
+}
+
+int pcf85063a_factory_reset(const struct device *dev, uint32_t *elapsed_us)
+{
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Alarms off, timer off, then CTRL1, CTRL2 and OFFSET after the
+	// address wraps from TIMER_MODE back to 0. The time is left alone.
+	uint8_t defaults[PCF85063A_RESET_BURST_LEN] = {
+		PCF85063A_SECOND_ALARM_EN,
+		PCF85063A_MINUTE_ALARM_EN,
+		PCF85063A_HOUR_ALARM_EN,
+		PCF85063A_DAY_ALARM_EN,
+		PCF85063A_WEEKDAY_ALARM_EN,
+		0,
+		PCF85063A_TIMER_MODE_FREQ_1_60 << PCF85063A_TIMER_MODE_FREQ_SHIFT,
+		config->reset_ctrl1,
+		pcf85063a_clkout_cof(config->reset_clkout_hz),
+		config->reset_offset,
+	};
+	uint8_t readback[PCF85063A_RESET_BURST_LEN];
+	uint32_t start = k_cycle_get_32();
+	uint32_t elapsed;
+	int ret;
+
+	ret = pcf85063a_bus_write_byte(&config->i2c, PCF85063A_CTRL1, PCF85063A_CTRL1_SOFT_RESET,
+				       __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to reset RTC. (err %i)", ret);
+		return ret;
+	}
+
+	ret = pcf85063a_bus_burst_write(&config->i2c, PCF85063A_SECOND_ALARM, defaults,
+					sizeof(defaults), __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to write RTC defaults. (err %i)", ret);
+		return ret;
+	}
+
+	ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_SECOND_ALARM, readback,
+				       sizeof(readback), __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to read back RTC defaults. (err %i)", ret);
+		return ret;
+	}
+
+	if (memcmp(defaults, readback, sizeof(defaults)))
+	{
+		LOG_ERR("RTC defaults did not verify.");
+		return -EIO;
+	}
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	/* Staged changes are dropped along with everything else */
+	memcpy(data->cfg_shadow, &defaults[PCF85063A_RESET_BURST_LEN - sizeof(data->cfg_shadow)],
+	       sizeof(data->cfg_shadow));
+	memcpy(data->cfg_staged, data->cfg_shadow, sizeof(data->cfg_staged));
+#endif
+#ifdef CONFIG_PCF85063A_ANCHOR
+	/* The reset clears the prescaler along with the registers */
+	pcf85063a_drop_anchor(data);
+#endif
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	data->subsec_running = false;
+	data->subsec_calibrated = false;
+#endif
+#ifdef CONFIG_PCF85063A_ALARM
+	data->alarm_callback = NULL;
+	data->periodic_callback = NULL;
+	data->alarm_armed = false;
+	data->alarm_pending = false;
+	data->alarm_deadline_valid = false;
+	data->calendar_callback = NULL;
+	data->calendar_alarm_armed = false;
+#endif
+	ARG_UNUSED(data);
+
+	elapsed = k_cyc_to_us_ceil32(k_cycle_get_32() - start);
+	if (elapsed_us)
+	{
+		*elapsed_us = elapsed;
+	}
+
+	LOG_INF("Factory reset in %u us.", elapsed);
+
+	return 0;
+}
+#endif /* CONFIG_PCF85063A_FACTORY_RESET */
+
+static int pcf85063a_start(const struct device *dev)
+{
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	return pcf85063a_write_through(dev, PCF85063A_CTRL1, PCF85063A_CTRL1_STOP, 0, __func__);
+#else
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
+
+	// Turn it back on (active low)
+	uint8_t reg = 0;
+	uint8_t mask = PCF85063A_CTRL1_STOP;
+
+	// Write back the updated register value
+	int ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL1, mask, reg, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to stop RTC. (err %i)", ret);
+		return ret;
+	}
+
+	return 0;
+#endif
+}
+
+static int pcf85063a_stop(const struct device *dev)
+{
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	return pcf85063a_write_through(dev, PCF85063A_CTRL1, PCF85063A_CTRL1_STOP,
+				       PCF85063A_CTRL1_STOP, __func__);
+#else
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
+
+	// Turn it off
+	uint8_t reg = PCF85063A_CTRL1_STOP;
+	uint8_t mask = PCF85063A_CTRL1_STOP;
+
+	// Write back the updated register value
+	int ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL1, mask, reg, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to stop RTC. (err %i)", ret);
+		return ret;
+	}
+
+	return 0;
+#endif
+}
+
+static int pcf85063a_get_value(const struct device *dev, uint32_t *ticks)
+{
+	return 0;
+}
+
+#ifdef CONFIG_PCF85063A_ALARM
+/* Countdown source clock per TIMER_MODE TCF setting, as a fraction of 1 Hz */
+static const struct
+{
+	uint16_t num;
+	uint16_t den;
+} pcf85063a_timer_freq[] = {
+	[PCF85063A_TIMER_MODE_FREQ_4K] = {4096, 1},
+	[PCF85063A_TIMER_MODE_FREQ_64] = {64, 1},
+	[PCF85063A_TIMER_MODE_FREQ_1] = {1, 1},
+	[PCF85063A_TIMER_MODE_FREQ_1_60] = {1, 60},
+};
+
+static uint64_t pcf85063a_timer_ticks_to_us(uint32_t ticks, uint8_t freq)
+{
+	return (uint64_t)ticks * USEC_PER_SEC * pcf85063a_timer_freq[freq].den /
+	       pcf85063a_timer_freq[freq].num;
+}
+
+static int pcf85063a_program_timer(const struct device *dev, uint8_t freq, uint8_t value,
+				   bool pulse, const char *op)
+{
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
+
+	// Ret val for error checking
+	int ret;
+
+	if (freq > PCF85063A_TIMER_MODE_FREQ_1_60)
+	{
+		return -EINVAL;
+	}
+
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	struct pcf85063a_data *data = dev->data;
+
+	// The fractional second counter owns the countdown
+	if (data->subsec_running)
+	{
+		return -EBUSY;
+	}
+#endif
+
+	// Clear any flags in CTRL2
+	uint8_t reg = 0;
+	uint8_t mask = PCF85063A_CTRL2_TF;
+
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2, mask, reg, op);
+	if (ret)
+	{
+		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
+		return ret;
+	}
+
+	// Write the tick count, in periods of the selected source clock
+	ret = pcf85063a_bus_write_byte(&config->i2c, PCF85063A_TIMER_VALUE, value, op);
+	if (ret)
+	{
+		LOG_ERR("Unable to set RTC timer value. (err %i)", ret);
+		return ret;
+	}
+
+	// Select the source clock and enable
+	reg = (freq << PCF85063A_TIMER_MODE_FREQ_SHIFT) | PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN;
+	mask = PCF85063A_TIMER_MODE_FREQ_MASK | PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN |
+	       PCF85063A_TIMER_MODE_INT_TI_TP;
+
+	// Pulse the INT pin each period instead of following TF
+	if (pulse)
+	{
+		reg |= PCF85063A_TIMER_MODE_INT_TI_TP;
+	}
+
+	// Write back the updated register value
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_TIMER_MODE, mask, reg, op);
+	if (ret)
+	{
+		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * There is one countdown. It belongs to whoever armed it with a callback, who
+ * may re-arm it; anyone else gets -EBUSY until it expires or is cancelled.
+ */
+static int pcf85063a_claim_countdown(const struct pcf85063a_data *data,
+				     counter_alarm_callback_t callback,
+				     pcf85063a_periodic_callback_t periodic_callback)
+{
+	if (!data->alarm_armed)
+	{
+		return 0;
+	}
+
+	if (data->periodic_callback)
+	{
+		return data->periodic_callback == periodic_callback ? 0 : -EBUSY;
+	}
+
+	if (data->alarm_callback)
+	{
+		return data->alarm_callback == callback && !periodic_callback ? 0 : -EBUSY;
+	}
+
+	return 0;
+}
+
+int pcf85063a_set_countdown(const struct device *dev, uint8_t freq, uint8_t value,
+			    counter_alarm_callback_t callback, void *user_data)
+{
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
+
+	ret = pcf85063a_claim_countdown(data, callback, NULL);
+	if (ret)
+	{
+		return ret;
+	}
+
+	data->periodic_callback = NULL;
+
+	ret = pcf85063a_program_timer(dev, freq, value, false, __func__);
+	if (ret)
+	{
+		return ret;
+	}
+
+	if (callback && !config->int_gpio.port)
+	{
+		LOG_WRN("No int-gpios, alarm callback will not be called.");
+	}
+
+	data->alarm_callback = callback;
+	data->alarm_user_data = user_data;
+	data->alarm_ticks = value;
+	data->alarm_freq = freq;
+	data->alarm_armed = true;
+	data->alarm_pending = false;
+	data->alarm_deadline_ticks = k_uptime_ticks() +
+				     k_us_to_ticks_ceil64(pcf85063a_timer_ticks_to_us(value, freq));
+	data->alarm_deadline_valid = true;
+
+	return 0;
+}
+
+int pcf85063a_set_periodic(const struct device *dev, uint8_t freq, uint8_t value,
+			   pcf85063a_periodic_callback_t callback, void *user_data)
+{
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
+
+	if (!config->int_gpio.port)
+	{
+		return -ENOTSUP;
+	}
+
+	if (value == 0)
+	{
+		return -EINVAL;
+	}
+
+	ret = pcf85063a_claim_countdown(data, NULL, callback);
+	if (ret)
+	{
+		return ret;
+	}
+
+	// Set before the first pulse can arrive
+	data->alarm_callback = NULL;
+	data->periodic_user_data = user_data;
+	data->periodic_callback = callback;
+
+	ret = pcf85063a_program_timer(dev, freq, value, true, __func__);
+	if (ret)
+	{
+		data->periodic_callback = NULL;
+		return ret;
+	}
+
+	data->alarm_ticks = value;
+	data->alarm_freq = freq;
+	data->alarm_armed = true;
+	data->alarm_pending = false;
+	data->alarm_deadline_valid = false;
+
+	return 0;
+}
+
+static int pcf85063a_set_alarm(
+	const struct device *dev, uint8_t chan_id, const struct counter_alarm_cfg *alarm_cfg)
+{
+	ARG_UNUSED(chan_id);
+
+	// Ticks are 1 sec
+	return pcf85063a_set_countdown(dev, PCF85063A_TIMER_MODE_FREQ_1, (uint8_t)alarm_cfg->ticks,
+				       alarm_cfg->callback, alarm_cfg->user_data);
+}
+
+static int pcf85063a_cancel_alarm(const struct device *dev, uint8_t chan_id)
+{
+
+	// Get the config and data pointers
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+
+	// Ret val for error checking
+	int ret;
+
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	// No alarm can be armed, leave the fractional second counter running
+	if (data->subsec_running)
+	{
+		return 0;
+	}
+#endif
+
+	// Clear any flags in CTRL2
+	uint8_t reg = 0;
+	uint8_t mask = PCF85063A_CTRL2_TF;
+
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2, mask, reg, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to set RTC alarm. (err %i)", ret);
+		return ret;
+	}
+
+	// Turn off all itnerrupts/timer mode
+	reg = 0;
+	mask = PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN | PCF85063A_TIMER_MODE_INT_TI_TP;
+
+	// Write back the updated register value
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_TIMER_MODE, mask, reg, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to cancel RTC alarm. (err %i)", ret);
+		return ret;
+	}
+
+	data->alarm_callback = NULL;
+	data->periodic_callback = NULL;
+	data->alarm_armed = false;
+	data->alarm_pending = false;
+	data->alarm_deadline_valid = false;
+
+	return 0;
+}
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+static void pcf85063a_notify(struct pcf85063a_data *data, enum pcf85063a_alarm_source source)
+{
+	struct k_poll_signal *signal = data->signal[source];
+	struct k_event *event = data->event;
+
+	if (signal)
+	{
+		k_poll_signal_raise(signal, source);
+	}
+
+	if (event)
+	{
+		k_event_post(event, BIT(source));
+	}
+}
+#endif
+
+static void pcf85063a_work_handler(struct k_work *work)
+{
+	struct pcf85063a_data *data = CONTAINER_OF(work, struct pcf85063a_data, work);
+	const struct device *dev = data->dev;
+	const struct pcf85063a_config *config = dev->config;
+	counter_alarm_callback_t callback;
+	pcf85063a_calendar_alarm_callback_t calendar_callback;
+	uint8_t reg, flags;
+	bool periodic = false;
+	int ret;
+
+	ret = pcf85063a_bus_read_byte(&config->i2c, PCF85063A_CTRL2, &reg, PCF85063A_BUS_OP_INT);
+	if (ret)
+	{
+		LOG_ERR("Unable to get RTC CTRL2 reg. (err %i)", ret);
+		return;
+	}
+
+	flags = reg & (PCF85063A_CTRL2_TF | PCF85063A_CTRL2_AF);
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	// The fractional second counter reloads with TF setting unattended
+	if (data->subsec_running)
+	{
+		flags &= ~PCF85063A_CTRL2_TF;
+	}
+#endif
+	if (!flags)
+	{
+		return;
+	}
+
+	// Periodic pulses were already delivered from the interrupt
+	if (data->periodic_callback)
+	{
+		periodic = true;
+	}
+
+	// Counter alarms are one shot, keep the countdown from reloading
+	if ((flags & PCF85063A_CTRL2_TF) && !periodic)
+	{
+		ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_TIMER_MODE,
+						PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN,
+						0, PCF85063A_BUS_OP_INT);
+		if (ret)
+		{
+			LOG_ERR("Unable to stop RTC timer. (err %i)", ret);
+		}
+	}
+
+	// Clear only the flags seen. Writing 1 to a flag leaves it alone, so one
+	// that raised since the read is not lost.
+	ret = pcf85063a_bus_write_byte(&config->i2c, PCF85063A_CTRL2,
+				       (reg | PCF85063A_CTRL2_TF | PCF85063A_CTRL2_AF) & ~flags,
+				       PCF85063A_BUS_OP_INT);
+	if (ret)
+	{
+		LOG_ERR("Unable to clear RTC alarm. (err %i)", ret);
+	}
+
+	if ((flags & PCF85063A_CTRL2_TF) && !periodic)
+	{
+		callback = data->alarm_callback;
+		data->alarm_callback = NULL;
+		data->alarm_armed = false;
+		data->alarm_pending = false;
+		data->alarm_deadline_valid = false;
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+		// Wake waiting threads before running callbacks
+		pcf85063a_notify(data, PCF85063A_ALARM_COUNTDOWN);
+#endif
+
+		if (callback)
+		{
+			callback(dev, 0, data->alarm_ticks, data->alarm_user_data);
+		}
+	}
+
+	if (flags & PCF85063A_CTRL2_AF)
+	{
+		calendar_callback = data->calendar_callback;
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+		pcf85063a_notify(data, PCF85063A_ALARM_CALENDAR);
+#endif
+
+		if (calendar_callback)
+		{
+			calendar_callback(dev, data->calendar_user_data);
+		}
+	}
+}
+
+static void pcf85063a_int_handler(const struct device *port, struct gpio_callback *cb,
+				  gpio_port_pins_t pins)
+{
+	struct pcf85063a_data *data = CONTAINER_OF(cb, struct pcf85063a_data, int_cb);
+	pcf85063a_periodic_callback_t periodic_callback = data->periodic_callback;
+
+	ARG_UNUSED(port);
+	ARG_UNUSED(pins);
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+	data->int_cycles = k_cycle_get_32();
+#endif
+
+	// Pulses need no flag handling, only go to the bus if the calendar alarm
+	// may share the pin
+	if (periodic_callback)
+	{
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+		pcf85063a_notify(data, PCF85063A_ALARM_COUNTDOWN);
+#endif
+
+		periodic_callback(data->dev, k_uptime_ticks(), data->periodic_user_data);
+
+		if (!data->calendar_alarm_armed)
+		{
+			return;
+		}
+	}
+
+	k_work_submit(&data->work);
+}
+
+static int pcf85063a_init_interrupt(const struct device *dev)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	int ret;
+
+	if (!gpio_is_ready_dt(&config->int_gpio))
+	{
+		LOG_ERR("Interrupt GPIO not ready.");
+		return -ENODEV;
+	}
+
+	ret = gpio_pin_configure_dt(&config->int_gpio, GPIO_INPUT);
+	if (ret)
+	{
+		return ret;
+	}
+
+	gpio_init_callback(&data->int_cb, pcf85063a_int_handler, BIT(config->int_gpio.pin));
+
+	ret = gpio_add_callback(config->int_gpio.port, &data->int_cb);
+	if (ret)
+	{
+		return ret;
+	}
+
+	return gpio_pin_interrupt_configure_dt(&config->int_gpio, GPIO_INT_EDGE_TO_ACTIVE);
+}
+
+/*
+ * Rebuild the alarm state from the register image read at init, so an alarm
+ * armed before an MCU reset is picked up rather than reprogrammed.
+ */
+static void pcf85063a_restore_alarm(const struct device *dev, const uint8_t *regs)
+{
+	struct pcf85063a_data *data = dev->data;
+	uint8_t mode = regs[PCF85063A_TIMER_MODE];
+
+	if ((mode & (PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN)) ==
+	    (PCF85063A_TIMER_MODE_EN | PCF85063A_TIMER_MODE_INT_EN))
+	{
+		data->alarm_armed = true;
+		data->alarm_ticks = regs[PCF85063A_TIMER_VALUE];
+		data->alarm_freq = (mode & PCF85063A_TIMER_MODE_FREQ_MASK) >> PCF85063A_TIMER_MODE_FREQ_SHIFT;
+		data->alarm_pending = (regs[PCF85063A_CTRL2] & PCF85063A_CTRL2_TF) != 0;
+
+		LOG_INF("Countdown already armed, %u ticks left.", data->alarm_ticks);
+	}
+
+	// Calendar alarm fields are enabled by clearing their AEN bit
+	if (regs[PCF85063A_CTRL2] & PCF85063A_CTRL2_AIE)
+	{
+		for (int i = PCF85063A_SECOND_ALARM; i <= PCF85063A_WEEKDAY_ALARM; i++)
+		{
+			if (!(regs[i] & PCF85063A_SECOND_ALARM_EN))
+			{
+				data->calendar_alarm_armed = true;
+				break;
+			}
+		}
+	}
+}
+
+int pcf85063a_attach_alarm(const struct device *dev, counter_alarm_callback_t callback,
+			   void *user_data)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	if (!data->alarm_armed)
+	{
+		return -ENOENT;
+	}
+
+	data->alarm_user_data = user_data;
+	data->alarm_callback = callback;
+
+	// It may have expired before anyone was listening
+	if (data->alarm_pending)
+	{
+		k_work_submit(&data->work);
+	}
+
+	return 0;
+}
+
+int pcf85063a_get_alarm_remaining(const struct device *dev, uint32_t *ticks, uint64_t *us)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	uint64_t remaining_us;
+	uint8_t value;
+	int ret;
+
+	if (!data->alarm_armed)
+	{
+		return -ENOENT;
+	}
+
+	if (data->alarm_pending)
+	{
+		remaining_us = 0;
+		value = 0;
+	}
+	else if (data->alarm_deadline_valid)
+	{
+		// Armed by us, the uptime deadline answers without the bus
+		int64_t left = data->alarm_deadline_ticks - k_uptime_ticks();
+
+		remaining_us = left > 0 ? k_ticks_to_us_floor64(left) : 0;
+		value = DIV_ROUND_UP(remaining_us * pcf85063a_timer_freq[data->alarm_freq].num,
+				     (uint64_t)USEC_PER_SEC * pcf85063a_timer_freq[data->alarm_freq].den);
+	}
+	else
+	{
+		ret = pcf85063a_bus_read_byte(&config->i2c, PCF85063A_TIMER_VALUE, &value,
+					      __func__);
+		if (ret)
+		{
+			LOG_ERR("Unable to get RTC timer value. (err %i)", ret);
+			return ret;
+		}
+
+		remaining_us = pcf85063a_timer_ticks_to_us(value, data->alarm_freq);
+
+		// Cache it so the next query stays off the bus
+		data->alarm_deadline_ticks = k_uptime_ticks() + k_us_to_ticks_ceil64(remaining_us);
+		data->alarm_deadline_valid = true;
+	}
+
+	if (ticks)
+	{
+		*ticks = value;
+	}
+
+	if (us)
+	{
+		*us = remaining_us;
+	}
+
+	return 0;
+}
+
+int pcf85063a_set_calendar_alarm(const struct device *dev, const struct tm *time,
+				 pcf85063a_calendar_alarm_callback_t callback, void *user_data)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	uint8_t regs[5];
+	int ret;
+
+	// Match on second, minute, hour and day of month. AEN bits low enable.
+	regs[0] = bin2bcd(time->tm_sec);
+	regs[1] = bin2bcd(time->tm_min);
+	regs[2] = bin2bcd(time->tm_hour);
+	regs[3] = bin2bcd(time->tm_mday);
+	regs[4] = PCF85063A_WEEKDAY_ALARM_EN;
+
+	// Keep a stale match from firing while the fields are rewritten
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2,
+					PCF85063A_CTRL2_AIE | PCF85063A_CTRL2_AF | PCF85063A_CTRL2_TF,
+					PCF85063A_CTRL2_TF, __func__);
+	if (ret == 0)
+	{
+		ret = pcf85063a_bus_burst_write(&config->i2c, PCF85063A_SECOND_ALARM, regs,
+						sizeof(regs), __func__);
+	}
+
+	if (ret)
+	{
+		LOG_ERR("Unable to set calendar alarm. (err %i)", ret);
+		return ret;
+	}
+
+	data->calendar_callback = callback;
+	data->calendar_user_data = user_data;
+	data->calendar_alarm_armed = true;
+
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2, PCF85063A_CTRL2_AIE,
+					PCF85063A_CTRL2_AIE, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to enable calendar alarm. (err %i)", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+int pcf85063a_cancel_calendar_alarm(const struct device *dev)
+{
+	const struct pcf85063a_config *config = dev->config;
+	struct pcf85063a_data *data = dev->data;
+	int ret;
+
+	ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2,
+					PCF85063A_CTRL2_AIE | PCF85063A_CTRL2_AF | PCF85063A_CTRL2_TF,
+					PCF85063A_CTRL2_TF, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to cancel calendar alarm. (err %i)", ret);
+		return ret;
+	}
+
+	data->calendar_callback = NULL;
+	data->calendar_alarm_armed = false;
+
+	return 0;
+}
+
+bool pcf85063a_calendar_alarm_armed(const struct device *dev)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	return data->calendar_alarm_armed;
+}
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+int pcf85063a_set_alarm_signal(const struct device *dev, enum pcf85063a_alarm_source source,
+			       struct k_poll_signal *signal)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	if (source >= PCF85063A_ALARM_SOURCES)
+	{
+		return -EINVAL;
+	}
+
+	data->signal[source] = signal;
+
+	return 0;
+}
+
+int pcf85063a_set_alarm_event(const struct device *dev, struct k_event *event)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	data->event = event;
+
+	return 0;
+}
+
+uint32_t pcf85063a_last_int_cycles(const struct device *dev)
+{
+	struct pcf85063a_data *data = dev->data;
+
+	return data->int_cycles;
+}
+#endif /* CONFIG_PCF85063A_ALARM_SIGNAL */
+
+#endif /* CONFIG_PCF85063A_ALARM */
+
+static int pcf85063a_set_top_value(const struct device *dev, const struct counter_top_cfg *cfg)
+{
+	return 0;
+}
+
+static uint32_t pcf85063a_get_pending_int(const struct device *dev)
+{
+
+	// Get the config pointer
+	const struct pcf85063a_config *config = dev->config;
+
+	// Start with 0
+	uint8_t reg = 0;
+
+	// Write back the updated register value
+	int ret = pcf85063a_bus_read_byte(&config->i2c, PCF85063A_CTRL2, &reg, __func__);
+	if (ret)
+	{
+		LOG_ERR("Unable to get RTC CTRL2 reg. (err %i)", ret);
+		return ret;
+	}
+
+	// Return 1 if interrupt. 0 if no flag.
+	return (reg & PCF85063A_CTRL2_TF) ? 1U : 0U;
+}
+
+static uint32_t pcf85063a_get_top_value(const struct device *dev)
+{
+	return 0;
+}
+
+static const struct counter_driver_api pcf85063a_api = {
+	.start = pcf85063a_start,
+	.stop = pcf85063a_stop,
+	.get_value = pcf85063a_get_value,
+#ifdef CONFIG_PCF85063A_ALARM
+	.set_alarm = pcf85063a_set_alarm,
+	.cancel_alarm = pcf85063a_cancel_alarm,
+#endif
+	.set_top_value = pcf85063a_set_top_value,
+	.get_pending_int = pcf85063a_get_pending_int,
+	.get_top_value = pcf85063a_get_top_value,
+};
+
+int pcf85063a_init(const struct device *dev)
+{
+
+	/* Get the i2c device binding*/
+	const struct pcf85063a_config *config = dev->config;
+	/* Set I2C Device. */
+	if (!device_is_ready(config->i2c.bus))
+	{
+		LOG_ERR("Failed to get pointer to %s device!", config->i2c.bus->name);
+		return -EINVAL;
+	}
+
+	/* Check if it's alive, reading control through timer registers in one go. */
+	uint8_t regs[PCF85063A_TIMER_MODE + 1];
+	int ret = pcf85063a_bus_burst_read(&config->i2c, PCF85063A_CTRL1, regs, sizeof(regs),
+					   __func__);
 	if (ret)
 	{
 		LOG_ERR("Failed to read from PCF85063A! (err %i)", ret);
 		return -EIO;
 	}
 
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	struct pcf85063a_data *cache = dev->data;
+
+	memcpy(cache->cfg_shadow, &regs[PCF85063A_CTRL1], sizeof(cache->cfg_shadow));
+	memcpy(cache->cfg_staged, cache->cfg_shadow, sizeof(cache->cfg_staged));
+#endif
+
+#ifdef CONFIG_PCF85063A_CLKOUT_TIMER
+	/* The kernel runs off CLKOUT, it has to stay at 32.768 kHz */
+	if ((regs[PCF85063A_CTRL2] & PCF85063A_CTRL2_COF_MASK) != PCF85063A_CTRL2_COF_32K)
+	{
+		LOG_WRN("CLKOUT was not 32.768 kHz, kernel time before now is off.");
+		ret = pcf85063a_bus_update_byte(&config->i2c, PCF85063A_CTRL2,
+						PCF85063A_CTRL2_COF_MASK, PCF85063A_CTRL2_COF_32K,
+						__func__);
+		if (ret)
+		{
+			LOG_ERR("Unable to set CLKOUT. (err %i)", ret);
+			return ret;
+		}
+	}
+#endif
+
+#ifdef CONFIG_PCF85063A_ALARM
+	struct pcf85063a_data *data = dev->data;
+
+	data->dev = dev;
+	k_work_init(&data->work, pcf85063a_work_handler);
+
+	pcf85063a_restore_alarm(dev, regs);
+
+	if (config->int_gpio.port)
+	{
+		ret = pcf85063a_init_interrupt(dev);
+		if (ret)
+		{
+			LOG_ERR("Failed to set up interrupt. (err %i)", ret);
+			return ret;
+		}
+	}
+#endif
+
 	LOG_INF("%s is initialized!", dev->name);
 
 	return 0;
 }
 
+#ifdef CONFIG_PCF85063A_ALARM
+#define PCF85063A_INT_GPIO_INIT(inst) .int_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, int_gpios, {0}),
+#else
+#define PCF85063A_INT_GPIO_INIT(inst)
+#endif
+
+#ifdef CONFIG_PCF85063A_FACTORY_RESET
+#define PCF85063A_RESET_INIT(inst)								\
+	.reset_ctrl1 = DT_INST_PROP_OR(inst, quartz_load_femtofarads, 7000) == 12500		\
+			       ? PCF85063A_CTRL1_CAP_SEL						\
+			       : 0,								\
+	.reset_clkout_hz = DT_INST_PROP_OR(inst, clkout_frequency, 32768),			\
+	.reset_offset = DT_INST_PROP_OR(inst, nxp_offset, 0),
+#else
+#define PCF85063A_RESET_INIT(inst)
+#endif
+
 /* Main instantiation matcro */
 #define PCF85063A_DEFINE(inst)							\
-	static struct pcf85063a_data pcf85063a_data_##inst = {			\
+	static struct pcf85063a_data pcf85063a_data_##inst;			\
+	static const struct pcf85063a_config pcf85063a_config_##inst = {	\
+		.info = {							\
+			.max_top_value = 0xff,					\
+			.freq = 1,						\
+			.channels = PCF85063A_CHANNELS,				\
+		},								\
 		.i2c = I2C_DT_SPEC_INST_GET(inst),				\
-	};									\
-	static const struct counter_config_info pcf85063_cfg_info_##inst = {	\
-		.max_top_value = 0xff,						\
-		.freq = 1,							\
-		.channels = 1,							\
+		PCF85063A_INT_GPIO_INIT(inst)					\
+		PCF85063A_RESET_INIT(inst)					\
 	};									\
 	DEVICE_DT_INST_DEFINE(inst,						\
 						  pcf85063a_init, NULL,                              \
-						  &pcf85063a_data_##inst, &pcf85063_cfg_info_##inst, \
+						  &pcf85063a_data_##inst, &pcf85063a_config_##inst, \
 						  POST_KERNEL, CONFIG_APPLICATION_INIT_PRIORITY,             \
 						  &pcf85063a_api);
 
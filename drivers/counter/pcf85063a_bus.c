@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Bus occupancy and charge accounting. The driver routes each transfer
+ * through pcf85063a_bus_charge() with its wire bytes and starts; the cost is
+ * added to the public driver function it was made for and to the calling
+ * thread's tag.
+ * Functions beyond CONFIG_PCF85063A_BUS_OPS share one overflow entry, and
+ * the total is kept on its own so it never depends on the table size.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <drivers/counter/pcf85063a_bus.h>
+
+struct op_usage
+{
+	const char *op;
+	struct pcf85063a_bus_usage usage;
+};
+
+struct thread_tag
+{
+	k_tid_t thread;
+	uint8_t tag;
+};
+
+static struct op_usage ops[CONFIG_PCF85063A_BUS_OPS];
+static struct pcf85063a_bus_usage overflow;
+static struct pcf85063a_bus_usage total;
+static struct pcf85063a_bus_usage tags[CONFIG_PCF85063A_BUS_TAGS];
+static struct thread_tag threads[CONFIG_PCF85063A_BUS_TAG_THREADS];
+static struct k_spinlock lock;
+
+static void add(struct pcf85063a_bus_usage *usage, uint32_t bytes, uint32_t starts,
+		uint64_t busy_ns, uint64_t charge_pc)
+{
+	usage->transfers++;
+	usage->bytes += bytes;
+	usage->starts += starts;
+	usage->busy_ns += busy_ns;
+	usage->charge_pc += charge_pc;
+}
+
+/* Callers hold lock */
+static uint8_t current_tag(void)
+{
+	k_tid_t self = k_current_get();
+
+	for (size_t i = 0; i < ARRAY_SIZE(threads); i++)
+	{
+		if (threads[i].thread == self)
+		{
+			return threads[i].tag;
+		}
+	}
+
+	return 0;
+}
+
+int pcf85063a_bus_charge(const char *op, uint32_t bytes, uint32_t starts, int ret)
+{
+	uint64_t bits = (uint64_t)bytes * 9 + starts * 2;
+	uint64_t busy_ns = bits * NSEC_PER_SEC / CONFIG_PCF85063A_BUS_HZ +
+			   CONFIG_PCF85063A_BUS_OVERHEAD_US * NSEC_PER_USEC;
+	uint64_t charge_pc = busy_ns * CONFIG_PCF85063A_BUS_ACTIVE_UA / NSEC_PER_USEC;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct pcf85063a_bus_usage *usage = &overflow;
+	uint8_t tag = current_tag();
+
+	for (size_t i = 0; i < ARRAY_SIZE(ops); i++)
+	{
+		// Function names are unique literals, the pointer identifies them
+		if (ops[i].op == op || !ops[i].op)
+		{
+			ops[i].op = op;
+			usage = &ops[i].usage;
+			break;
+		}
+	}
+
+	add(usage, bytes, starts, busy_ns, charge_pc);
+	add(&total, bytes, starts, busy_ns, charge_pc);
+
+	if (tag < ARRAY_SIZE(tags))
+	{
+		add(&tags[tag], bytes, starts, busy_ns, charge_pc);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return ret;
+}
+
+uint8_t pcf85063a_bus_tag_set(uint8_t tag)
+{
+	k_tid_t self = k_current_get();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct thread_tag *slot = NULL;
+	uint8_t previous = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(threads); i++)
+	{
+		if (threads[i].thread == self)
+		{
+			slot = &threads[i];
+			previous = slot->tag;
+			break;
+		}
+
+		if (!slot && !threads[i].thread)
+		{
+			slot = &threads[i];
+		}
+	}
+
+	// Tag 0 needs no slot
+	if (slot)
+	{
+		slot->thread = tag ? self : NULL;
+		slot->tag = tag;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return previous;
+}
+
+int pcf85063a_bus_usage_by_op(size_t index, const char **op, struct pcf85063a_bus_usage *usage)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	size_t used = 0;
+	int ret = -ENOENT;
+
+	while (used < ARRAY_SIZE(ops) && ops[used].op)
+	{
+		used++;
+	}
+
+	if (index < used)
+	{
+		*op = ops[index].op;
+		*usage = ops[index].usage;
+		ret = 0;
+	}
+	else if (index == used && overflow.transfers)
+	{
+		// Functions that found the table full
+		*op = PCF85063A_BUS_OP_OTHER;
+		*usage = overflow;
+		ret = 0;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return ret;
+}
+
+int pcf85063a_bus_usage_by_tag(uint8_t tag, struct pcf85063a_bus_usage *usage)
+{
+	k_spinlock_key_t key;
+
+	if (tag >= ARRAY_SIZE(tags))
+	{
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&lock);
+	*usage = tags[tag];
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+void pcf85063a_bus_usage_total(struct pcf85063a_bus_usage *usage)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*usage = total;
+
+	k_spin_unlock(&lock, key);
+}
+
+void pcf85063a_bus_usage_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(ops, 0, sizeof(ops));
+	memset(tags, 0, sizeof(tags));
+	memset(&overflow, 0, sizeof(overflow));
+	memset(&total, 0, sizeof(total));
+
+	k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * I2C emulator for the PCF85063A, for native_sim and bus cost measurements.
+ * Models the register file with address auto-increment, a running clock
+ * derived from kernel uptime, and the countdown timer driving int-gpios
+ * through the GPIO emulator. The calendar alarm is not modelled.
+ */
+
+#define DT_DRV_COMPAT nxp_pcf85063a
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/sys/timeutil.h>
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_calendar.h>
+#include <drivers/counter/pcf85063a_emul.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define PCF85063A_EMUL_REGS (PCF85063A_TIMER_MODE + 1)
+
+struct pcf85063a_emul_cfg
+{
+	struct gpio_dt_spec int_gpio;
+};
+
+struct pcf85063a_emul_data
+{
+	const struct emul *target;
+	uint8_t regs[PCF85063A_EMUL_REGS];
+	uint8_t ptr;
+
+	/* Time registers hold the time at this uptime */
+	int64_t epoch;
+	int64_t epoch_uptime_ms;
+
+	/* Uptime of the last prescaler restart, and the 4096 Hz tick the countdown started on */
+	int64_t prescaler_origin_us;
+	int64_t timer_start_4k;
+
+	struct k_timer timer;
+	struct pcf85063a_emul_stats stats;
+};
+
+/* Countdown source clock periods in microseconds, per TCF */
+static const uint32_t pcf85063a_emul_period_us[] = {
+	[PCF85063A_TIMER_MODE_FREQ_4K] = USEC_PER_SEC / 4096,
+	[PCF85063A_TIMER_MODE_FREQ_64] = USEC_PER_SEC / 64,
+	[PCF85063A_TIMER_MODE_FREQ_1] = USEC_PER_SEC,
+	[PCF85063A_TIMER_MODE_FREQ_1_60] = 60 * USEC_PER_SEC,
+};
+
+static void pcf85063a_emul_set_int(const struct emul *target, bool active)
+{
+	const struct pcf85063a_emul_cfg *cfg = target->cfg;
+	struct pcf85063a_emul_data *data = target->data;
+
+	if (!cfg->int_gpio.port)
+	{
+		return;
+	}
+
+	if (active)
+	{
+		data->stats.interrupts++;
+	}
+
+	// The pin is driven at its physical level, INT is open drain active low
+	gpio_emul_input_set(cfg->int_gpio.port, cfg->int_gpio.pin,
+			    (cfg->int_gpio.dt_flags & GPIO_ACTIVE_LOW) ? !active : active);
+}
+
+/* Months are the chip's 1-12 here, whatever the driver puts in them */
+static void pcf85063a_emul_latch_time(struct pcf85063a_emul_data *data)
+{
+	int64_t now_ms = k_uptime_get();
+	int64_t elapsed = (now_ms - data->epoch_uptime_ms) / MSEC_PER_SEC;
+	time_t epoch;
+	struct tm time;
+
+	if (data->regs[PCF85063A_CTRL1] & PCF85063A_CTRL1_STOP)
+	{
+		elapsed = 0;
+	}
+
+	data->epoch += elapsed;
+	data->epoch_uptime_ms += elapsed * MSEC_PER_SEC;
+
+	epoch = (time_t)data->epoch;
+	gmtime_r(&epoch, &time);
+
+	data->regs[PCF85063A_SECONDS] = (data->regs[PCF85063A_SECONDS] & PCF85063A_SECONDS_OS) |
+					bin2bcd(time.tm_sec);
+	data->regs[PCF85063A_MINUTES] = bin2bcd(time.tm_min);
+	data->regs[PCF85063A_HOURS] = bin2bcd(time.tm_hour);
+	data->regs[PCF85063A_DAYS] = bin2bcd(time.tm_mday);
+	data->regs[PCF85063A_WEEKDAYS] = time.tm_wday;
+	data->regs[PCF85063A_MONTHS] = bin2bcd(time.tm_mon + 1);
+	data->regs[PCF85063A_YEARS] = bin2bcd(time.tm_year % 100);
+}
+
+/*
+ * The chip does not check what it is given, and gmtime would quietly turn a
+ * bad date into another one. Keep the clock and count the write instead, so
+ * results from a driver that writes bad dates cannot pass unnoticed.
+ */
+static void pcf85063a_emul_store_time(struct pcf85063a_emul_data *data)
+{
+	uint32_t month = bcd2bin(data->regs[PCF85063A_MONTHS] & PCF85063A_MONTHS_MASK);
+	uint32_t day = bcd2bin(data->regs[PCF85063A_DAYS] & PCF85063A_DAYS_MASK);
+	int32_t year = bcd2bin(data->regs[PCF85063A_YEARS]) + 2000;
+
+	if (month < 1 || month > 12 || day < 1 || day > pcf85063a_days_in_month(year, month))
+	{
+		LOG_ERR("Emulator: invalid date %04d-%02u-%02u written.", year, month, day);
+		data->stats.invalid_dates++;
+		pcf85063a_emul_latch_time(data);
+		return;
+	}
+
+	struct tm time = {
+		.tm_sec = bcd2bin(data->regs[PCF85063A_SECONDS] & PCF85063A_SECONDS_MASK),
+		.tm_min = bcd2bin(data->regs[PCF85063A_MINUTES] & PCF85063A_MINUTES_MASK),
+		.tm_hour = bcd2bin(data->regs[PCF85063A_HOURS] & PCF85063A_HOURS_MASK),
+		.tm_mday = bcd2bin(data->regs[PCF85063A_DAYS] & PCF85063A_DAYS_MASK),
+		.tm_mon = bcd2bin(data->regs[PCF85063A_MONTHS] & PCF85063A_MONTHS_MASK) - 1,
+		.tm_year = bcd2bin(data->regs[PCF85063A_YEARS]) + 100,
+	};
+
+	data->epoch = timeutil_timegm64(&time);
+	data->epoch_uptime_ms = k_uptime_get();
+	data->prescaler_origin_us = data->epoch_uptime_ms * USEC_PER_MSEC;
+}
+
+/* 4096 Hz prescaler ticks since it was last restarted by a time write */
+static int64_t pcf85063a_emul_prescaler_4k(struct pcf85063a_emul_data *data)
+{
+	int64_t us = k_ticks_to_us_floor64(k_uptime_ticks()) - data->prescaler_origin_us;
+
+	return us * 4096 / USEC_PER_SEC;
+}
+
+static void pcf85063a_emul_timer_expiry(struct k_timer *timer)
+{
+	struct pcf85063a_emul_data *data = CONTAINER_OF(timer, struct pcf85063a_emul_data, timer);
+	uint8_t mode = data->regs[PCF85063A_TIMER_MODE];
+
+	data->regs[PCF85063A_CTRL2] |= PCF85063A_CTRL2_TF;
+
+	if (!(mode & PCF85063A_TIMER_MODE_INT_EN))
+	{
+		return;
+	}
+
+	pcf85063a_emul_set_int(data->target, true);
+
+	// Pulse mode releases the pin again, level mode holds it until TF clears
+	if (mode & PCF85063A_TIMER_MODE_INT_TI_TP)
+	{
+		pcf85063a_emul_set_int(data->target, false);
+	}
+}
+
+static void pcf85063a_emul_update_timer(struct pcf85063a_emul_data *data)
+{
+	uint8_t mode = data->regs[PCF85063A_TIMER_MODE];
+	uint8_t freq = (mode & PCF85063A_TIMER_MODE_FREQ_MASK) >> PCF85063A_TIMER_MODE_FREQ_SHIFT;
+	k_timeout_t period;
+
+	if (!(mode & PCF85063A_TIMER_MODE_EN) || data->regs[PCF85063A_TIMER_VALUE] == 0)
+	{
+		k_timer_stop(&data->timer);
+		return;
+	}
+
+	// The countdown starts on the next source clock edge
+	if (freq == PCF85063A_TIMER_MODE_FREQ_4K)
+	{
+		data->timer_start_4k = pcf85063a_emul_prescaler_4k(data) + 1;
+	}
+
+	// The countdown reloads from TIMER_VALUE and keeps going
+	period = K_USEC((uint64_t)data->regs[PCF85063A_TIMER_VALUE] * pcf85063a_emul_period_us[freq]);
+	k_timer_start(&data->timer, period, period);
+}
+
+/* Software reset values. The time registers keep counting. */
+static void pcf85063a_emul_reset_regs(struct pcf85063a_emul_data *data)
+{
+	memset(data->regs, 0, PCF85063A_SECONDS);
+
+	for (int i = PCF85063A_SECOND_ALARM; i <= PCF85063A_WEEKDAY_ALARM; i++)
+	{
+		data->regs[i] = PCF85063A_SECOND_ALARM_EN;
+	}
+
+	data->regs[PCF85063A_TIMER_VALUE] = 0;
+	data->regs[PCF85063A_TIMER_MODE] = PCF85063A_TIMER_MODE_FREQ_1_60 << PCF85063A_TIMER_MODE_FREQ_SHIFT;
+}
+
+static uint8_t pcf85063a_emul_read(struct pcf85063a_emul_data *data, uint8_t reg)
+{
+	uint8_t mode = data->regs[PCF85063A_TIMER_MODE];
+	uint8_t reload = data->regs[PCF85063A_TIMER_VALUE];
+
+	// The 4096 Hz source is a prescaler stage, it stays in phase with the seconds
+	if (reg == PCF85063A_TIMER_VALUE && reload && (mode & PCF85063A_TIMER_MODE_EN) &&
+	    ((mode & PCF85063A_TIMER_MODE_FREQ_MASK) >> PCF85063A_TIMER_MODE_FREQ_SHIFT) ==
+		    PCF85063A_TIMER_MODE_FREQ_4K)
+	{
+		int64_t elapsed = pcf85063a_emul_prescaler_4k(data) - data->timer_start_4k;
+
+		return elapsed < 0 ? reload : reload - elapsed % reload;
+	}
+
+	if (reg == PCF85063A_TIMER_VALUE && k_timer_remaining_ticks(&data->timer))
+	{
+		uint8_t freq = (mode & PCF85063A_TIMER_MODE_FREQ_MASK) >> PCF85063A_TIMER_MODE_FREQ_SHIFT;
+
+		return DIV_ROUND_UP(k_ticks_to_us_ceil64(k_timer_remaining_ticks(&data->timer)),
+				    pcf85063a_emul_period_us[freq]);
+	}
+
+	return data->regs[reg];
+}
+
+static void pcf85063a_emul_write(struct pcf85063a_emul_data *data, uint8_t reg, uint8_t value,
+				 bool *time_written)
+{
+	const struct emul *target = data->target;
+	uint8_t flags;
+
+	switch (reg)
+	{
+	case PCF85063A_CTRL1:
+		if (value & PCF85063A_CTRL1_SR)
+		{
+			pcf85063a_emul_reset_regs(data);
+			k_timer_stop(&data->timer);
+			pcf85063a_emul_set_int(target, false);
+			return;
+		}
+		break;
+	case PCF85063A_CTRL2:
+		// Flags can only be cleared, writing 1 leaves them alone
+		flags = PCF85063A_CTRL2_AF | PCF85063A_CTRL2_TF;
+		value = (value & ~flags) | (data->regs[reg] & value & flags);
+		data->regs[reg] = value;
+
+		if (!(value & PCF85063A_CTRL2_TF))
+		{
+			pcf85063a_emul_set_int(target, false);
+		}
+		return;
+	case PCF85063A_SECONDS ... PCF85063A_YEARS:
+		*time_written = true;
+		break;
+	default:
+		break;
+	}
+
+	data->regs[reg] = value;
+
+	if (reg == PCF85063A_TIMER_VALUE || reg == PCF85063A_TIMER_MODE)
+	{
+		pcf85063a_emul_update_timer(data);
+	}
+}
+
+static int pcf85063a_emul_transfer(const struct emul *target, struct i2c_msg *msgs, int num_msgs,
+				   int addr)
+{
+	struct pcf85063a_emul_data *data = target->data;
+	bool time_written = false;
+
+	ARG_UNUSED(addr);
+
+	data->stats.transfers++;
+
+	// Time registers are latched when the transfer starts
+	pcf85063a_emul_latch_time(data);
+
+	for (int i = 0; i < num_msgs; i++)
+	{
+		struct i2c_msg *msg = &msgs[i];
+		uint32_t start = 0;
+
+		data->stats.messages++;
+		data->stats.bus_bytes += msg->len + 1;
+
+		if (msg->flags & I2C_MSG_READ)
+		{
+			for (uint32_t j = 0; j < msg->len; j++)
+			{
+				msg->buf[j] = pcf85063a_emul_read(data, data->ptr);
+				data->ptr = (data->ptr + 1) % PCF85063A_EMUL_REGS;
+			}
+
+			data->stats.bytes_read += msg->len;
+			continue;
+		}
+
+		// A write starts with the register address, unless it continues one
+		if (i == 0 || (msgs[i - 1].flags & I2C_MSG_READ))
+		{
+			if (msg->len == 0 || msg->buf[0] >= PCF85063A_EMUL_REGS)
+			{
+				return -EIO;
+			}
+
+			data->ptr = msg->buf[0];
+			start = 1;
+		}
+
+		for (uint32_t j = start; j < msg->len; j++)
+		{
+			pcf85063a_emul_write(data, data->ptr, msg->buf[j], &time_written);
+			data->ptr = (data->ptr + 1) % PCF85063A_EMUL_REGS;
+		}
+
+		data->stats.bytes_written += msg->len;
+	}
+
+	if (time_written)
+	{
+		pcf85063a_emul_store_time(data);
+	}
+
+	return 0;
+}
+
+void pcf85063a_emul_get_stats(const struct emul *target, struct pcf85063a_emul_stats *stats)
+{
+	struct pcf85063a_emul_data *data = target->data;
+
+	*stats = data->stats;
+}
+
+void pcf85063a_emul_reset_stats(const struct emul *target)
+{
+	struct pcf85063a_emul_data *data = target->data;
+
+	memset(&data->stats, 0, sizeof(data->stats));
+}
+
+static int pcf85063a_emul_init(const struct emul *target, const struct device *parent)
+{
+	const struct pcf85063a_emul_cfg *cfg = target->cfg;
+	struct pcf85063a_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	data->target = target;
+	k_timer_init(&data->timer, pcf85063a_emul_timer_expiry, NULL);
+
+	// Power on state: oscillator flagged as stopped, 2000-01-01
+	pcf85063a_emul_reset_regs(data);
+	data->regs[PCF85063A_SECONDS] = PCF85063A_SECONDS_OS;
+	data->regs[PCF85063A_DAYS] = 1;
+	data->regs[PCF85063A_MONTHS] = 1;
+	pcf85063a_emul_store_time(data);
+
+	// INT idles released
+	if (cfg->int_gpio.port)
+	{
+		pcf85063a_emul_set_int(target, false);
+	}
+
+	return 0;
+}
+
+static const struct i2c_emul_api pcf85063a_emul_api = {
+	.transfer = pcf85063a_emul_transfer,
+};
+
+#define PCF85063A_EMUL(inst)								\
+	static struct pcf85063a_emul_data pcf85063a_emul_data_##inst;			\
+	static const struct pcf85063a_emul_cfg pcf85063a_emul_cfg_##inst = {		\
+		.int_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, int_gpios, {0}),		\
+	};										\
+	EMUL_DT_INST_DEFINE(inst, pcf85063a_emul_init, &pcf85063a_emul_data_##inst,	\
+			    &pcf85063a_emul_cfg_##inst, &pcf85063a_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(PCF85063A_EMUL)
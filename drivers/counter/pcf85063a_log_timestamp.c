@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Log timestamps in wall time. Each timestamp is kernel uptime plus the
+ * anchor offset, so a log message costs an uptime read, a sequence checked
+ * load and an add. A delayable work item checks the anchor periodically,
+ * which measures the edge again once it has aged out, and at once when a
+ * time write has dropped it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/atomic.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+static bool installed;
+
+/* Set when a message found the anchor gone, cleared by the resync */
+static atomic_t resync_requested;
+
+static void resync_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(resync_work, resync_handler);
+
+static log_timestamp_t timestamp_get(void)
+{
+	int64_t ticks;
+
+	if (pcf85063a_get_realtime_ticks(RTC, &ticks) == 0)
+	{
+		return (log_timestamp_t)ticks;
+	}
+
+	// set_time() dropped the anchor. Keep the last offset rather than switch
+	// to 1970 based uptime, and find the new edge now rather than at the next
+	// refresh. The provider is only installed once there has been an anchor.
+	if (atomic_cas(&resync_requested, 0, 1))
+	{
+		k_work_reschedule(&resync_work, K_NO_WAIT);
+	}
+
+	return (log_timestamp_t)(k_uptime_ticks() + pcf85063a_anchor_offset_ticks(RTC->data));
+}
+
+static void resync_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	int ret;
+
+	atomic_clear(&resync_requested);
+
+	ret = pcf85063a_sync_anchor(RTC);
+	if (ret == 0 && !installed)
+	{
+		installed = log_set_timestamp_func(timestamp_get, CONFIG_SYS_CLOCK_TICKS_PER_SEC) == 0;
+	}
+
+	/* Retry soon until the RTC holds a valid time */
+	k_work_schedule(dwork, installed && ret == 0
+				       ? K_SECONDS(CONFIG_PCF85063A_LOG_TIMESTAMP_RESYNC_S)
+				       : K_SECONDS(1));
+}
+
+static int pcf85063a_log_timestamp_init(void)
+{
+	const struct device *rtc = RTC;
+
+	if (!device_is_ready(rtc))
+	{
+		return -ENODEV;
+	}
+
+	/* Edge polling can take a second, keep it out of boot */
+	k_work_schedule(&resync_work, K_NO_WAIT);
+
+	return 0;
+}
+
+SYS_INIT(pcf85063a_log_timestamp_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
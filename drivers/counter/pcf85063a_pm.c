@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Long sleep offload. A custom PM policy only lets the SoC into its deepest
+ * state once the PCF85063A countdown is armed to wake it no later than the
+ * next kernel timeout.
+ *
+ * The policy runs in the idle thread with interrupts locked, so it cannot
+ * talk I2C. It only notes a long enough idle period; entry into the shallow
+ * state it picks then kicks a one tick timer, which wakes the offload thread
+ * to arm the countdown and hand control back to idle. On wake the thread
+ * compares RTC elapsed time against kernel elapsed time. Only the system
+ * timer driver may announce ticks, so a shortfall is handed to the CLKOUT
+ * system timer when that is the kernel's clock, and only reported otherwise.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/pm/pm.h>
+#include <zephyr/pm/policy.h>
+#include <zephyr/pm/state.h>
+#include <zephyr/sys/timeutil.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+#define OFFLOAD_THRESHOLD_TICKS \
+	k_ms_to_ticks_ceil64(CONFIG_PCF85063A_PM_OFFLOAD_THRESHOLD_MS)
+
+/* Without the INT pin the countdown cannot wake the SoC */
+BUILD_ASSERT(DT_NODE_HAS_PROP(DT_COMPAT_GET_ANY_STATUS_OKAY(nxp_pcf85063a), int_gpios),
+	     "PCF85063A_PM_OFFLOAD needs int-gpios on the nxp,pcf85063a node");
+
+/* Charge rate saved while offloaded, none for a board that draws more in deep sleep */
+#define SAVED_UA MAX(CONFIG_PCF85063A_PM_IDLE_CURRENT_UA - CONFIG_PCF85063A_PM_DEEP_CURRENT_UA, 0)
+
+/* Give up on an RTC wake this long after it was due */
+#define WAKE_GRACE_MS 2000
+
+static K_SEM_DEFINE(offload_sem, 0, 1);
+static K_SEM_DEFINE(wake_sem, 0, 1);
+
+/* Kernel deadline the policy asked us to cover, in uptime ticks */
+static int64_t requested_deadline;
+static bool requested;
+
+/* Policy found an idle period to offload, the entry notifier kicks the thread */
+static bool kick;
+
+/* Deadline that could not be offloaded, not asked for again */
+static int64_t declined_deadline = -1;
+
+/* Set once the thread is running */
+static bool enabled;
+
+/* RTC wake programmed for this uptime */
+static int64_t armed_deadline;
+static bool armed;
+
+static struct pcf85063a_pm_stats stats;
+
+static void kick_timer_expiry(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+
+	k_sem_give(&offload_sem);
+}
+
+static K_TIMER_DEFINE(kick_timer, kick_timer_expiry, NULL);
+
+static void rtc_wake(const struct device *dev, uint8_t chan_id, uint32_t ticks, void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(chan_id);
+	ARG_UNUSED(ticks);
+	ARG_UNUSED(user_data);
+
+	k_sem_give(&wake_sem);
+}
+
+const struct pm_state_info *pm_policy_next_state(uint8_t cpu, int32_t ticks)
+{
+	const struct pm_state_info *states;
+	uint8_t num = pm_state_cpu_get_all(cpu, &states);
+	int64_t now = k_uptime_ticks();
+	bool offloaded = false;
+
+	if (num == 0)
+	{
+		return NULL;
+	}
+
+	if (enabled && (ticks == K_TICKS_FOREVER || ticks >= OFFLOAD_THRESHOLD_TICKS))
+	{
+		int64_t deadline = ticks == K_TICKS_FOREVER ? INT64_MAX : now + ticks;
+
+		// Only while the RTC wake is still ahead
+		if (armed && now < armed_deadline && armed_deadline <= deadline)
+		{
+			offloaded = true;
+		}
+		else if (!requested && !armed && deadline != declined_deadline)
+		{
+			requested = true;
+			requested_deadline = deadline;
+			kick = true;
+		}
+	}
+
+	/* Deepest state only with the RTC set to wake us, the rest by residency */
+	for (int i = num - 1; i >= 0; i--)
+	{
+		const struct pm_state_info *state = &states[i];
+		uint32_t min_ticks = k_us_to_ticks_ceil32(state->min_residency_us +
+							  state->exit_latency_us);
+
+		if (i == num - 1 && !offloaded)
+		{
+			continue;
+		}
+
+		if (pm_policy_state_lock_is_active(state->state, state->substate_id))
+		{
+			continue;
+		}
+
+		if (ticks == K_TICKS_FOREVER || (uint32_t)ticks >= min_ticks)
+		{
+			return state;
+		}
+	}
+
+	return NULL;
+}
+
+static void pm_notify_entry(enum pm_state state)
+{
+	const struct pm_state_info *states;
+	uint8_t num = pm_state_cpu_get_all(0, &states);
+
+	if (num && state == states[num - 1].state)
+	{
+		stats.deep_entries++;
+	}
+
+	// Wake from the shallow state in a tick so the thread can arm the RTC
+	if (kick)
+	{
+		kick = false;
+		k_timer_start(&kick_timer, K_TICKS(1), K_NO_WAIT);
+	}
+}
+
+static struct pm_notifier notifier = {
+	.state_entry = pm_notify_entry,
+};
+
+static int rtc_epoch(const struct device *rtc, int64_t *epoch)
+{
+	struct tm time;
+	int ret = pcf85063a_get_time(rtc, &time);
+
+	if (ret == 0)
+	{
+		*epoch = timeutil_timegm64(&time);
+	}
+
+	return ret;
+}
+
+static void offload_thread(void *p1, void *p2, void *p3)
+{
+	const struct device *rtc = RTC;
+	int64_t rtc_before, rtc_after, uptime_before, remaining_ms, error_ms, wait;
+	uint8_t freq, value;
+	int ret;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready, sleep offload disabled.");
+		return;
+	}
+
+	pm_notifier_register(&notifier);
+	enabled = true;
+
+	for (;;)
+	{
+		k_sem_take(&offload_sem, K_FOREVER);
+
+		/* Wake early by the resume margin, never late */
+		remaining_ms = k_ticks_to_ms_floor64(requested_deadline - k_uptime_ticks()) -
+			       CONFIG_PCF85063A_PM_WAKE_MARGIN_MS;
+		if (remaining_ms < CONFIG_PCF85063A_PM_OFFLOAD_THRESHOLD_MS)
+		{
+			requested = false;
+			continue;
+		}
+
+		if (remaining_ms / MSEC_PER_SEC <= UINT8_MAX)
+		{
+			freq = PCF85063A_TIMER_MODE_FREQ_1;
+			value = remaining_ms / MSEC_PER_SEC;
+		}
+		else
+		{
+			freq = PCF85063A_TIMER_MODE_FREQ_1_60;
+			value = MIN(remaining_ms / (60 * MSEC_PER_SEC), UINT8_MAX);
+		}
+
+		ret = rtc_epoch(rtc, &rtc_before);
+		if (ret == 0)
+		{
+			uptime_before = k_uptime_get();
+			ret = pcf85063a_set_countdown(rtc, freq, value, rtc_wake, NULL);
+		}
+
+		if (ret == -EBUSY)
+		{
+			// The countdown belongs to someone else, stay in the shallow state
+			LOG_DBG("RTC countdown in use, not offloading.");
+			declined_deadline = requested_deadline;
+			requested = false;
+			stats.declined++;
+			continue;
+		}
+
+		if (ret)
+		{
+			LOG_ERR("Unable to arm RTC wake. (err %i)", ret);
+			requested = false;
+			continue;
+		}
+
+		armed_deadline = k_uptime_ticks() +
+				 k_ms_to_ticks_floor64(freq == PCF85063A_TIMER_MODE_FREQ_1
+							       ? value * MSEC_PER_SEC
+							       : value * 60 * MSEC_PER_SEC);
+		armed = true;
+		requested = false;
+		stats.offloads++;
+
+		// A kernel timeout after the RTC wake, in case the wake never comes
+		wait = armed_deadline - k_uptime_ticks() + k_ms_to_ticks_ceil64(WAKE_GRACE_MS);
+		ret = k_sem_take(&wake_sem, K_TICKS(MAX(wait, 0)));
+		armed = false;
+
+		if (ret)
+		{
+			LOG_WRN("RTC wake missed, cancelling.");
+			counter_cancel_channel_alarm(rtc, 0);
+			stats.missed++;
+			continue;
+		}
+
+		/* Reconcile. RTC reads resolve whole seconds. */
+		if (rtc_epoch(rtc, &rtc_after) == 0)
+		{
+			int64_t rtc_ms = (rtc_after - rtc_before) * MSEC_PER_SEC;
+
+			error_ms = rtc_ms - (k_uptime_get() - uptime_before);
+
+#ifdef CONFIG_PCF85063A_CLKOUT_TIMER
+			// Up to a second of the error can be read rounding. Only the rest
+			// is certain, so the kernel is never moved past RTC time.
+			if (error_ms >= MSEC_PER_SEC)
+			{
+				int64_t correct_ms = error_ms - (MSEC_PER_SEC - 1);
+
+				pcf85063a_clkout_timer_skip((uint64_t)correct_ms *
+							    CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC /
+							    MSEC_PER_SEC);
+				stats.corrected_ms += correct_ms;
+			}
+#endif
+
+			stats.offloaded_ms += rtc_ms;
+			stats.last_error_ms = (int32_t)error_ms;
+			if (error_ms > stats.max_error_ms || -error_ms > stats.max_error_ms)
+			{
+				stats.max_error_ms = (int32_t)(error_ms < 0 ? -error_ms : error_ms);
+			}
+
+			stats.saved_uas += (uint64_t)rtc_ms * SAVED_UA / MSEC_PER_SEC;
+
+			LOG_DBG("Offloaded %lld ms, kernel behind by %lld ms.", rtc_ms, error_ms);
+		}
+	}
+}
+
+K_THREAD_DEFINE(pcf85063a_pm_offload, CONFIG_PCF85063A_PM_OFFLOAD_STACK_SIZE, offload_thread,
+		NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+int pcf85063a_pm_get_stats(struct pcf85063a_pm_stats *out)
+{
+	*out = stats;
+
+	return 0;
+}
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/timeutil.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_posix_timer.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+/* Day of month matching only works within a month, step longer waits */
+#define MAX_ALARM_AHEAD_S (27LL * 24 * 60 * 60)
+
+struct rtc_timer
+{
+	bool in_use;
+	bool armed;
+	struct sigevent evp;
+	/* Absolute CLOCK_REALTIME expiry and reload, in ns */
+	int64_t expiry_ns;
+	int64_t interval_ns;
+	int overrun;
+};
+
+static struct rtc_timer timers[CONFIG_PCF85063A_POSIX_TIMER_MAX];
+static K_MUTEX_DEFINE(lock);
+
+/* Epoch second currently programmed into the calendar alarm, 0 if none */
+static int64_t programmed_s;
+
+/* Retry period when the RTC cannot be read or written on expiry */
+#define RETRY_MS 1000
+
+static int rtc_now_s(int64_t *now)
+{
+	struct tm time;
+	int ret = pcf85063a_get_time(RTC, &time);
+
+	if (ret == 0)
+	{
+		*now = timeutil_timegm64(&time);
+	}
+
+	return ret;
+}
+
+static struct rtc_timer *to_timer(timer_t timerid)
+{
+	struct rtc_timer *timer = (struct rtc_timer *)timerid;
+
+	if (timer < timers || timer >= timers + ARRAY_SIZE(timers) || !timer->in_use)
+	{
+		return NULL;
+	}
+
+	return timer;
+}
+
+static void alarm_fired(const struct device *dev, void *user_data);
+
+static void retry_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	alarm_fired(RTC, NULL);
+}
+
+static K_WORK_DELAYABLE_DEFINE(retry_work, retry_handler);
+
+/* Put the nearest armed expiry into the RTC. Called with lock held. */
+static int program_nearest(int64_t now_s)
+{
+	int64_t nearest_ns = INT64_MAX;
+	int64_t target_s;
+	struct tm time;
+	time_t t;
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++)
+	{
+		struct rtc_timer *timer = &timers[i];
+
+		if (timer->armed && timer->expiry_ns < nearest_ns)
+		{
+			nearest_ns = timer->expiry_ns;
+		}
+	}
+
+	if (nearest_ns == INT64_MAX)
+	{
+		programmed_s = 0;
+		return pcf85063a_cancel_calendar_alarm(RTC);
+	}
+
+	/* First second edge at or after the expiry, and never in the past */
+	target_s = DIV_ROUND_UP(nearest_ns, (int64_t)NSEC_PER_SEC);
+	target_s = CLAMP(target_s, now_s + 1, now_s + MAX_ALARM_AHEAD_S);
+
+	if (target_s == programmed_s)
+	{
+		return 0;
+	}
+
+	t = (time_t)target_s;
+	gmtime_r(&t, &time);
+
+	programmed_s = target_s;
+
+	return pcf85063a_set_calendar_alarm(RTC, &time, alarm_fired, NULL);
+}
+
+static void alarm_fired(const struct device *dev, void *user_data)
+{
+	struct sigevent notify[CONFIG_PCF85063A_POSIX_TIMER_MAX];
+	size_t count = 0;
+	int64_t now_s, now_ns;
+	int ret;
+
+	ARG_UNUSED(dev);
+	ARG_UNUSED(user_data);
+
+	// The calendar alarm is spent, without a retry every timer would stall
+	ret = rtc_now_s(&now_s);
+	if (ret)
+	{
+		LOG_WRN("Unable to read RTC on timer expiry, retrying. (err %i)", ret);
+		k_work_schedule(&retry_work, K_MSEC(RETRY_MS));
+		return;
+	}
+
+	now_ns = now_s * NSEC_PER_SEC;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	programmed_s = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++)
+	{
+		struct rtc_timer *timer = &timers[i];
+
+		if (!timer->armed || timer->expiry_ns > now_ns)
+		{
+			continue;
+		}
+
+		if (timer->interval_ns)
+		{
+			int64_t missed = (now_ns - timer->expiry_ns) / timer->interval_ns;
+
+			timer->overrun = (int)MIN(missed, INT_MAX);
+			timer->expiry_ns += (missed + 1) * timer->interval_ns;
+		}
+		else
+		{
+			timer->overrun = 0;
+			timer->armed = false;
+		}
+
+		notify[count++] = timer->evp;
+	}
+
+	ret = program_nearest(now_s);
+	if (ret)
+	{
+		LOG_WRN("Unable to program next timer expiry, retrying. (err %i)", ret);
+		programmed_s = 0;
+		k_work_schedule(&retry_work, K_MSEC(RETRY_MS));
+	}
+
+	k_mutex_unlock(&lock);
+
+	/* Notify outside the lock so handlers can re-arm */
+	for (size_t i = 0; i < count; i++)
+	{
+		if (notify[i].sigev_notify == SIGEV_THREAD && notify[i].sigev_notify_function)
+		{
+			notify[i].sigev_notify_function(notify[i].sigev_value);
+		}
+	}
+}
+
+static int64_t timespec_to_ns(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void ns_to_timespec(int64_t ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+int pcf85063a_timer_create(clockid_t clockid, struct sigevent *evp, timer_t *timerid)
+{
+	if (clockid != CLOCK_REALTIME || timerid == NULL ||
+	    (evp && evp->sigev_notify != SIGEV_NONE && evp->sigev_notify != SIGEV_THREAD))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++)
+	{
+		struct rtc_timer *timer = &timers[i];
+
+		if (timer->in_use)
+		{
+			continue;
+		}
+
+		*timer = (struct rtc_timer){.in_use = true};
+		if (evp)
+		{
+			timer->evp = *evp;
+		}
+		else
+		{
+			timer->evp.sigev_notify = SIGEV_NONE;
+		}
+
+		*timerid = (timer_t)timer;
+
+		k_mutex_unlock(&lock);
+		return 0;
+	}
+
+	k_mutex_unlock(&lock);
+
+	errno = EAGAIN;
+	return -1;
+}
+
+int pcf85063a_timer_gettime(timer_t timerid, struct itimerspec *value)
+{
+	struct rtc_timer *timer = to_timer(timerid);
+	int64_t now_s;
+
+	if (timer == NULL)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (rtc_now_s(&now_s))
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	ns_to_timespec(timer->armed ? MAX(timer->expiry_ns - now_s * NSEC_PER_SEC, 1) : 0,
+		       &value->it_value);
+	ns_to_timespec(timer->interval_ns, &value->it_interval);
+
+	k_mutex_unlock(&lock);
+
+	return 0;
+}
+
+int pcf85063a_timer_settime(timer_t timerid, int flags, const struct itimerspec *value,
+			    struct itimerspec *ovalue)
+{
+	struct rtc_timer *timer = to_timer(timerid);
+	int64_t now_s, expiry_ns;
+	int ret;
+
+	if (timer == NULL || value == NULL || value->it_value.tv_nsec < 0 ||
+	    value->it_value.tv_nsec >= NSEC_PER_SEC || value->it_interval.tv_nsec < 0 ||
+	    value->it_interval.tv_nsec >= NSEC_PER_SEC)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (ovalue && pcf85063a_timer_gettime(timerid, ovalue))
+	{
+		return -1;
+	}
+
+	if (rtc_now_s(&now_s))
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	// The RTC reads whole seconds and now may be up to one later. Counting
+	// from the next second can only make a relative timer late, not early.
+	expiry_ns = timespec_to_ns(&value->it_value);
+	if (expiry_ns && !(flags & TIMER_ABSTIME))
+	{
+		expiry_ns += (now_s + 1) * NSEC_PER_SEC;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	timer->armed = expiry_ns != 0;
+	timer->expiry_ns = expiry_ns;
+	timer->interval_ns = timespec_to_ns(&value->it_interval);
+	timer->overrun = 0;
+
+	ret = program_nearest(now_s);
+
+	k_mutex_unlock(&lock);
+
+	if (ret)
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	return 0;
+}
+
+int pcf85063a_timer_getoverrun(timer_t timerid)
+{
+	struct rtc_timer *timer = to_timer(timerid);
+
+	if (timer == NULL)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	return timer->overrun;
+}
+
+int pcf85063a_timer_delete(timer_t timerid)
+{
+	struct rtc_timer *timer = to_timer(timerid);
+	int64_t now_s;
+	int ret = 0;
+
+	if (timer == NULL)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	timer->in_use = false;
+	if (timer->armed)
+	{
+		timer->armed = false;
+		ret = rtc_now_s(&now_s);
+		if (ret == 0)
+		{
+			ret = program_nearest(now_s);
+		}
+	}
+
+	k_mutex_unlock(&lock);
+
+	if (ret)
+	{
+		errno = EIO;
+		return -1;
+	}
+
+	return 0;
+}
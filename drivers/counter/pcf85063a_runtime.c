@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Run-hour and elapsed time meter. The RTC is read once at boot, and the
+ * time since the last saved record is added to the elapsed count. From then
+ * on the counters are the boot values plus uptime, so reading them needs no
+ * bus access. A copy lives in retained RAM, refreshed often since it does
+ * not wear, and settings are written rarely and at shutdown only. Plain
+ * __noinit RAM only survives warm resets; a retention area chosen as
+ * pcf85063a,runtime-retention can also survive system off.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/linker/section_tags.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_SETTINGS
+#include <zephyr/settings/settings.h>
+#endif
+
+#ifdef CONFIG_PCF85063A_RUNTIME_RETENTION
+#include <zephyr/retention/retention.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_calendar.h>
+#include <drivers/counter/pcf85063a_runtime.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+#ifdef CONFIG_PCF85063A_RUNTIME_RETENTION
+#define RETENTION DEVICE_DT_GET(DT_CHOSEN(pcf85063a_runtime_retention))
+#endif
+
+#define RUNTIME_MAGIC 0x52554e31 /* "RUN1" */
+#define RUNTIME_SETTINGS_KEY "pcf85063a/runtime"
+
+/* Counters as of the RTC time in epoch, when epoch_valid */
+struct runtime_record
+{
+	uint64_t elapsed_s;
+	uint64_t run_s;
+	int64_t epoch;
+	uint32_t boots;
+	uint32_t epoch_valid;
+};
+
+#ifndef CONFIG_PCF85063A_RUNTIME_RETENTION
+struct runtime_retained
+{
+	uint32_t magic;
+	struct runtime_record record;
+	uint32_t crc;
+};
+
+static __noinit struct runtime_retained retained;
+#endif
+
+/*
+ * Held from projecting a record to retaining it, so an older record cannot
+ * overwrite a newer one. A mutex, the retention API may sleep.
+ */
+static K_MUTEX_DEFINE(retain_lock);
+
+/* Record at boot_ms, everything else is projected from it */
+static struct runtime_record base;
+static int64_t boot_ms;
+static bool started;
+static struct k_spinlock lock;
+
+static int read_epoch(int64_t *epoch)
+{
+	struct tm time;
+	int ret;
+
+	if (!device_is_ready(RTC))
+	{
+		return -ENODEV;
+	}
+
+	// Seconds through years in one burst
+	ret = pcf85063a_get_time(RTC, &time);
+	if (ret)
+	{
+		return ret;
+	}
+
+	*epoch = pcf85063a_tm_to_epoch(&time);
+
+	return 0;
+}
+
+/* Base moved forward to now. Callers hold lock. */
+static void project(struct runtime_record *record)
+{
+	uint64_t up_s = (uint64_t)(k_uptime_get() - boot_ms) / MSEC_PER_SEC;
+
+	*record = base;
+	record->elapsed_s += up_s;
+	record->run_s += up_s;
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+	int64_t ticks;
+
+	// The anchor follows set_time(), a projected boot reading would not
+	if (pcf85063a_get_realtime_ticks(RTC, &ticks) == 0)
+	{
+		record->epoch = ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+		record->epoch_valid = true;
+		return;
+	}
+#endif
+
+	record->epoch += (int64_t)up_s;
+}
+
+/* Restart projection from record as of now. Callers hold lock. */
+static void rebase(const struct runtime_record *record)
+{
+	base = *record;
+	boot_ms = k_uptime_get();
+}
+
+#ifdef CONFIG_PCF85063A_RUNTIME_RETENTION
+/* The retention area checks its own prefix and checksum. Callers hold retain_lock. */
+static void retain(const struct runtime_record *record)
+{
+	int ret;
+
+	ret = retention_write(RETENTION, 0, (const uint8_t *)record, sizeof(*record));
+	if (ret)
+	{
+		LOG_ERR("Unable to retain run time. (err %i)", ret);
+	}
+}
+
+static bool load_retained(struct runtime_record *record)
+{
+	if (!device_is_ready(RETENTION))
+	{
+		LOG_ERR("Retention area not ready.");
+		return false;
+	}
+
+	if (retention_size(RETENTION) < (ssize_t)sizeof(*record))
+	{
+		LOG_ERR("Retention area too small for the run time record.");
+		return false;
+	}
+
+	if (retention_is_valid(RETENTION) != 1)
+	{
+		return false;
+	}
+
+	return retention_read(RETENTION, 0, (uint8_t *)record, sizeof(*record)) == 0;
+}
+#else
+/* Callers hold retain_lock */
+static void retain(const struct runtime_record *record)
+{
+	retained.magic = RUNTIME_MAGIC;
+	retained.record = *record;
+	retained.crc = crc32_ieee((const uint8_t *)&retained.record, sizeof(retained.record));
+}
+
+static bool load_retained(struct runtime_record *record)
+{
+	if (retained.magic != RUNTIME_MAGIC ||
+	    retained.crc != crc32_ieee((const uint8_t *)&retained.record, sizeof(retained.record)))
+	{
+		return false;
+	}
+
+	*record = retained.record;
+
+	return true;
+}
+#endif /* CONFIG_PCF85063A_RUNTIME_RETENTION */
+
+#ifdef CONFIG_SETTINGS
+static int load_direct(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+		       void *param)
+{
+	struct runtime_record *record = param;
+
+	// Only the exact key, and only the current layout
+	if (key != NULL || len != sizeof(*record))
+	{
+		return 0;
+	}
+
+	return read_cb(cb_arg, record, sizeof(*record)) == sizeof(*record) ? 1 : 0;
+}
+
+static bool load_saved(struct runtime_record *record)
+{
+	struct runtime_record saved = {0};
+	int ret;
+
+	ret = settings_subsys_init();
+	if (ret)
+	{
+		LOG_ERR("Unable to init settings. (err %i)", ret);
+		return false;
+	}
+
+	ret = settings_load_subtree_direct(RUNTIME_SETTINGS_KEY, load_direct, &saved);
+	if (ret || saved.boots == 0)
+	{
+		return false;
+	}
+
+	*record = saved;
+
+	return true;
+}
+
+static int save(const struct runtime_record *record)
+{
+	int ret;
+
+	ret = settings_save_one(RUNTIME_SETTINGS_KEY, record, sizeof(*record));
+	if (ret)
+	{
+		LOG_ERR("Unable to save run time. (err %i)", ret);
+	}
+
+	return ret;
+}
+#else
+static bool load_saved(struct runtime_record *record)
+{
+	ARG_UNUSED(record);
+
+	return false;
+}
+
+static int save(const struct runtime_record *record)
+{
+	ARG_UNUSED(record);
+
+	return 0;
+}
+#endif /* CONFIG_SETTINGS */
+
+static void retain_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct runtime_record record;
+	k_spinlock_key_t key;
+
+	k_mutex_lock(&retain_lock, K_FOREVER);
+	key = k_spin_lock(&lock);
+
+	project(&record);
+
+	k_spin_unlock(&lock, key);
+
+	retain(&record);
+	k_mutex_unlock(&retain_lock);
+
+	k_work_schedule(dwork, K_SECONDS(CONFIG_PCF85063A_RUNTIME_RETAIN_S));
+}
+
+static K_WORK_DELAYABLE_DEFINE(retain_work, retain_handler);
+
+#ifdef CONFIG_SETTINGS
+static void save_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct runtime_record record;
+	k_spinlock_key_t key;
+
+	k_mutex_lock(&retain_lock, K_FOREVER);
+	key = k_spin_lock(&lock);
+
+	project(&record);
+
+	k_spin_unlock(&lock, key);
+
+	retain(&record);
+	k_mutex_unlock(&retain_lock);
+
+	save(&record);
+
+	k_work_schedule(dwork, K_HOURS(CONFIG_PCF85063A_RUNTIME_SAVE_H));
+}
+
+static K_WORK_DELAYABLE_DEFINE(save_work, save_handler);
+#endif
+
+int pcf85063a_runtime_get(struct pcf85063a_runtime *runtime)
+{
+	struct runtime_record record;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (!started)
+	{
+		k_spin_unlock(&lock, key);
+		return -EAGAIN;
+	}
+
+	project(&record);
+
+	k_spin_unlock(&lock, key);
+
+	runtime->elapsed_s = record.elapsed_s;
+	runtime->run_s = record.run_s;
+	runtime->boots = record.boots;
+
+	return 0;
+}
+
+int pcf85063a_runtime_provision(void)
+{
+	struct runtime_record record;
+	k_spinlock_key_t key;
+
+	k_mutex_lock(&retain_lock, K_FOREVER);
+	key = k_spin_lock(&lock);
+
+	project(&record);
+	record.elapsed_s = 0;
+	record.run_s = 0;
+	record.boots = 1;
+	rebase(&record);
+	started = true;
+
+	k_spin_unlock(&lock, key);
+
+	retain(&record);
+	k_mutex_unlock(&retain_lock);
+
+	LOG_INF("Run time meter provisioned");
+
+	return save(&record);
+}
+
+int pcf85063a_runtime_shutdown(void)
+{
+	struct runtime_record record;
+	int64_t epoch;
+	bool known = read_epoch(&epoch) == 0;
+	k_spinlock_key_t key;
+
+	k_mutex_lock(&retain_lock, K_FOREVER);
+	key = k_spin_lock(&lock);
+
+	project(&record);
+	if (known)
+	{
+		record.epoch = epoch;
+		record.epoch_valid = true;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	retain(&record);
+	k_mutex_unlock(&retain_lock);
+
+	return save(&record);
+}
+
+static int pcf85063a_runtime_init(void)
+{
+	struct runtime_record record = {0};
+	int64_t epoch = 0;
+	bool fresh = false;
+	int ret;
+
+	ret = read_epoch(&epoch);
+	if (ret)
+	{
+		LOG_WRN("RTC time unknown, time spent off is not counted. (err %i)", ret);
+	}
+
+	// Retained RAM is refreshed more often than settings, so it wins when valid
+	if (load_retained(&record) || load_saved(&record))
+	{
+		if (!ret && record.epoch_valid && epoch >= record.epoch)
+		{
+			record.elapsed_s += (uint64_t)(epoch - record.epoch);
+		}
+	}
+	else
+	{
+		LOG_INF("No run time record, provisioning");
+		fresh = true;
+	}
+
+	record.boots++;
+	record.epoch = epoch;
+	record.epoch_valid = ret == 0;
+
+	k_mutex_lock(&retain_lock, K_FOREVER);
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	rebase(&record);
+	started = true;
+
+	k_spin_unlock(&lock, key);
+
+	retain(&record);
+	k_mutex_unlock(&retain_lock);
+
+	// The one boot time write, so a power cycle does not provision again
+	if (fresh)
+	{
+		save(&record);
+	}
+
+	k_work_schedule(&retain_work, K_SECONDS(CONFIG_PCF85063A_RUNTIME_RETAIN_S));
+#ifdef CONFIG_SETTINGS
+	k_work_schedule(&save_work, K_HOURS(CONFIG_PCF85063A_RUNTIME_SAVE_H));
+#endif
+
+	return 0;
+}
+
+SYS_INIT(pcf85063a_runtime_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * RTC timed sensor sampling. The countdown runs in pulse mode and the INT
+ * pin ISR only counts pulses; the fetch happens on the system work queue.
+ * Sample n is stamped first + n * period, with the period measured in RTC
+ * time, so timestamps follow the crystal and not the time the fetch ran.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/counter.h>
+#include <zephyr/drivers/sensor.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_sampler.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+static void sampler_pulse(const struct device *dev, int64_t uptime_ticks, void *user_data)
+{
+	struct pcf85063a_sampler *sampler = user_data;
+
+	ARG_UNUSED(dev);
+
+	if (atomic_inc(&sampler->pulses) == 0)
+	{
+		sampler->first_uptime_ticks = uptime_ticks;
+	}
+
+	k_work_submit(&sampler->work);
+}
+
+static void sampler_work(struct k_work *work)
+{
+	struct pcf85063a_sampler *sampler = CONTAINER_OF(work, struct pcf85063a_sampler, work);
+	struct pcf85063a_data *data = sampler->rtc->data;
+	uint32_t pulses = (uint32_t)atomic_get(&sampler->pulses);
+	uint32_t seq;
+	int ret;
+
+	if (pulses == sampler->handled)
+	{
+		return;
+	}
+
+	// Wall time of the first pulse, from the anchor
+	if (sampler->handled == 0)
+	{
+		sampler->first_ns = pcf85063a_realtime_ticks_to_ns(sampler->first_uptime_ticks +
+								   pcf85063a_anchor_offset_ticks(data));
+	}
+
+	// Only the newest pulse is sampled, the rest are counted as missed
+	seq = pulses - 1;
+	sampler->missed += pulses - sampler->handled - 1;
+	sampler->handled = pulses;
+
+	ret = sensor_sample_fetch(sampler->sensor);
+	if (ret)
+	{
+		LOG_WRN("Unable to fetch sample %u. (err %i)", seq, ret);
+	}
+
+	sampler->handler(sampler->sensor, sampler->first_ns + (int64_t)(seq * sampler->period_ns),
+			 seq, ret, sampler->user_data);
+}
+
+int pcf85063a_sampler_start(struct pcf85063a_sampler *sampler, uint8_t freq, uint8_t value)
+{
+	struct pcf85063a_anchor anchor;
+	uint64_t period_ns;
+	int ret;
+
+	// The 4096 Hz source is too fast to sample from the work queue
+	if (freq == PCF85063A_TIMER_MODE_FREQ_4K || freq > PCF85063A_TIMER_MODE_FREQ_1_60 ||
+	    value == 0 || !sampler->handler)
+	{
+		return -EINVAL;
+	}
+
+	if (!device_is_ready(sampler->rtc) || !device_is_ready(sampler->sensor))
+	{
+		return -ENODEV;
+	}
+
+	// Stamps come from the anchor, find one now rather than per sample
+	if (pcf85063a_get_anchor(sampler->rtc, &anchor) == -EAGAIN)
+	{
+		ret = pcf85063a_sync_anchor(sampler->rtc);
+		if (ret)
+		{
+			LOG_ERR("Unable to anchor RTC time. (err %i)", ret);
+			return ret;
+		}
+	}
+
+	switch (freq)
+	{
+	case PCF85063A_TIMER_MODE_FREQ_64:
+		period_ns = (uint64_t)value * NSEC_PER_SEC / 64;
+		break;
+	case PCF85063A_TIMER_MODE_FREQ_1:
+		period_ns = (uint64_t)value * NSEC_PER_SEC;
+		break;
+	default:
+		period_ns = (uint64_t)value * 60 * NSEC_PER_SEC;
+		break;
+	}
+
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+	struct pcf85063a_sync_stats stats;
+
+	// Positive drift means the RTC runs fast and its periods are short
+	pcf85063a_get_sync_stats(sampler->rtc, &stats);
+	period_ns -= (int64_t)period_ns * stats.drift_ppb / NSEC_PER_SEC;
+#endif
+
+	k_work_init(&sampler->work, sampler_work);
+	atomic_set(&sampler->pulses, 0);
+	sampler->handled = 0;
+	sampler->missed = 0;
+	sampler->period_ns = period_ns;
+
+	return pcf85063a_set_periodic(sampler->rtc, freq, value, sampler_pulse, sampler);
+}
+
+int pcf85063a_sampler_stop(struct pcf85063a_sampler *sampler)
+{
+	int ret = counter_cancel_channel_alarm(sampler->rtc, 0);
+
+	if (ret)
+	{
+		return ret;
+	}
+
+	k_work_cancel(&sampler->work);
+
+	if (sampler->missed)
+	{
+		LOG_INF("Sampler missed %u of %u pulses.", sampler->missed,
+			(uint32_t)atomic_get(&sampler->pulses));
+	}
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Sensor clock backend. Cycles are wall time in kernel ticks, kernel uptime
+ * plus the anchor offset, so a sensor driver stamping a frame pays an uptime
+ * read and an add. A delayable work item measures the edge again each time
+ * the anchor ages out, and at once when a time write has dropped it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/drivers/sensor_clock.h>
+#include <zephyr/sys/atomic.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET(DT_CHOSEN(zephyr_sensor_clock))
+
+/* Set when a stamp found the anchor gone, cleared by the resync */
+static atomic_t resync_requested;
+
+static void resync_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(resync_work, resync_handler);
+
+int sensor_clock_get_cycles(uint64_t *cycles)
+{
+	int64_t ticks;
+
+	if (pcf85063a_get_realtime_ticks(RTC, &ticks) == 0)
+	{
+		*cycles = (uint64_t)ticks;
+		return 0;
+	}
+
+	// An uptime stamp would be read back as a date in 1970, fail the frame instead
+	if (atomic_cas(&resync_requested, 0, 1))
+	{
+		k_work_reschedule(&resync_work, K_NO_WAIT);
+	}
+
+	return -EAGAIN;
+}
+
+uint64_t sensor_clock_cycles_to_ns(uint64_t cycles)
+{
+	return (uint64_t)pcf85063a_realtime_ticks_to_ns((int64_t)cycles);
+}
+
+static void resync_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	int ret;
+
+	atomic_clear(&resync_requested);
+
+	ret = pcf85063a_sync_anchor(RTC);
+	if (ret)
+	{
+		LOG_DBG("Unable to anchor sensor clock. (err %i)", ret);
+	}
+
+	/* A sync measures the edge again only once the anchor has aged out */
+	k_work_schedule(dwork, ret == 0 ? K_SECONDS(CONFIG_PCF85063A_ANCHOR_MAX_AGE_S)
+					: K_SECONDS(1));
+}
+
+static int pcf85063a_sensor_clock_init(void)
+{
+	if (!device_is_ready(RTC))
+	{
+		return -ENODEV;
+	}
+
+	/* Edge polling can take a second, keep it out of boot */
+	k_work_schedule(&resync_work, K_NO_WAIT);
+
+	return 0;
+}
+
+SYS_INIT(pcf85063a_sensor_clock_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * RTIO sensor timestamps on wall time. Zephyr has no hook to replace the
+ * clock sensor drivers stamp their buffers with, so the decode step is
+ * wrapped instead: the uptime stamp is shifted by the anchor offset, which
+ * is a few loads and no bus access.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_sensor_ts.h>
+
+int pcf85063a_sensor_realtime_ns(const struct device *rtc, uint64_t uptime_ns,
+				 uint64_t *realtime_ns)
+{
+	struct pcf85063a_data *data = rtc->data;
+
+	if (!data->anchor_valid)
+	{
+		return -EAGAIN;
+	}
+
+	*realtime_ns = uptime_ns + pcf85063a_realtime_ticks_to_ns(pcf85063a_anchor_offset_ticks(data));
+
+	return 0;
+}
+
+int pcf85063a_sensor_decode(const struct device *rtc, const struct sensor_decoder_api *decoder,
+			    const uint8_t *buffer, struct sensor_chan_spec chan_spec, uint32_t *fit,
+			    uint16_t max_count, void *data_out, int *ts_err)
+{
+	/* Every decoded type starts with the common header */
+	struct sensor_data_header *header = data_out;
+	int count;
+	int ret;
+
+	count = decoder->decode(buffer, chan_spec, fit, max_count, data_out);
+	if (count <= 0)
+	{
+		return count;
+	}
+
+	ret = pcf85063a_sensor_realtime_ns(rtc, header->base_timestamp_ns,
+					   &header->base_timestamp_ns);
+	if (ts_err)
+	{
+		*ts_err = ret;
+	}
+
+	return count;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_stream.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define STEP_SHIFT 16
+
+/* Wall time at an uptime, through the current anchor */
+static int64_t uptime_ns_to_wall_ns(const struct device *rtc, int64_t uptime_ns)
+{
+	return uptime_ns + pcf85063a_realtime_ticks_to_ns(pcf85063a_anchor_offset_ticks(rtc->data));
+}
+
+int pcf85063a_stream_start(struct pcf85063a_stream *stream, const struct device *rtc,
+			   uint32_t rate_hz, int32_t drift_ppb, int64_t first_uptime_ticks)
+{
+	struct pcf85063a_anchor anchor;
+	uint64_t step;
+	int ret;
+
+	if (rate_hz == 0)
+	{
+		return -EINVAL;
+	}
+
+	if (pcf85063a_get_anchor(rtc, &anchor) == -EAGAIN)
+	{
+		ret = pcf85063a_sync_anchor(rtc);
+		if (ret)
+		{
+			LOG_ERR("Unable to anchor RTC time. (err %i)", ret);
+			return ret;
+		}
+	}
+
+	// A fast sample clock means a short period
+	step = ((uint64_t)NSEC_PER_SEC << STEP_SHIFT) / rate_hz;
+	step -= (int64_t)step * drift_ppb / NSEC_PER_SEC;
+
+	stream->rtc = rtc;
+	stream->step = step;
+	stream->frac = 0;
+	stream->index = 0;
+	stream->base_uptime_ns = k_ticks_to_ns_floor64(first_uptime_ticks);
+	stream->base_ns = uptime_ns_to_wall_ns(rtc, stream->base_uptime_ns);
+
+	return 0;
+}
+
+/*
+ * Move the segment start up to the next sample. index * step would overflow
+ * after about 78 hours of samples at any rate, folding keeps it to one call.
+ */
+static void fold(struct pcf85063a_stream *stream)
+{
+	uint64_t advance = stream->frac + (uint64_t)stream->index * stream->step;
+
+	stream->base_ns += (int64_t)(advance >> STEP_SHIFT);
+	stream->base_uptime_ns += (int64_t)(advance >> STEP_SHIFT);
+	stream->frac = advance & BIT_MASK(STEP_SHIFT);
+	stream->index = 0;
+}
+
+void pcf85063a_stream_fill(struct pcf85063a_stream *stream, int64_t *timestamps, size_t count)
+{
+	fold(stream);
+
+	const int64_t base = stream->base_ns;
+	const uint64_t step = stream->step;
+	const uint64_t offset = stream->frac;
+
+	// No loop carried state, so this vectorizes where the target can
+	for (size_t i = 0; i < count; i++)
+	{
+		timestamps[i] = base + (int64_t)((offset + i * step) >> STEP_SHIFT);
+	}
+
+	stream->index += count;
+}
+
+int pcf85063a_stream_realign(struct pcf85063a_stream *stream)
+{
+	int64_t uptime_ns;
+	int ret;
+
+	ret = pcf85063a_sync_anchor(stream->rtc);
+	if (ret)
+	{
+		return ret;
+	}
+
+	// Uptime of the next sample, then its wall time through the new anchor
+	fold(stream);
+	uptime_ns = stream->base_uptime_ns;
+
+	stream->base_ns = uptime_ns_to_wall_ns(stream->rtc, uptime_ns);
+
+	return 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Time source arbitration. Sources either push samples or are pulled from
+ * the system work queue; after each change the best answer is worked out
+ * once and published, and readers only project it forward with uptime.
+ * The PCF85063A registers itself as a pulled source backed by the anchor.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_time_source.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+static struct pcf85063a_time_source *sources[CONFIG_PCF85063A_TIME_SOURCE_MAX];
+static K_MUTEX_DEFINE(sources_lock);
+
+/* Published best, projected by readers */
+static struct pcf85063a_time_sample best;
+static uint32_t best_drift_ppm;
+static const struct pcf85063a_time_source *best_source;
+static struct k_spinlock best_lock;
+
+static uint64_t projected_uncertainty(const struct pcf85063a_time_sample *sample,
+				      uint32_t drift_ppm, int64_t now_ms)
+{
+	return sample->uncertainty_ms + (uint64_t)MAX(now_ms - sample->uptime_ms, 0) * drift_ppm /
+						USEC_PER_SEC;
+}
+
+/* Callers hold sources_lock, returns -EAGAIN when no source qualifies */
+static int rank(void)
+{
+	int64_t now = k_uptime_get();
+	struct pcf85063a_time_source *top = NULL;
+	struct pcf85063a_time_sample result;
+	uint64_t top_u = UINT64_MAX;
+	k_spinlock_key_t key;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sources); i++)
+	{
+		struct pcf85063a_time_source *source = sources[i];
+		uint64_t u;
+
+		if (!source || !source->valid || !source->last.healthy ||
+		    now - source->last.uptime_ms > CONFIG_PCF85063A_TIME_SOURCE_MAX_AGE_S * MSEC_PER_SEC)
+		{
+			continue;
+		}
+
+		u = projected_uncertainty(&source->last, source->drift_ppm, now);
+		if (u < top_u)
+		{
+			top = source;
+			top_u = u;
+		}
+	}
+
+	if (!top)
+	{
+		key = k_spin_lock(&best_lock);
+		best_source = NULL;
+		k_spin_unlock(&best_lock, key);
+		return -EAGAIN;
+	}
+
+	result.epoch_ms = top->last.epoch_ms + (now - top->last.uptime_ms);
+	result.uptime_ms = now;
+	result.uncertainty_ms = (uint32_t)MIN(top_u, UINT32_MAX);
+	result.healthy = true;
+
+#ifdef CONFIG_PCF85063A_TIME_SOURCE_BLEND
+	/* Offsets from the best, weighted by 1/u^2 in fixed point */
+	int64_t sum = 0;
+	uint64_t weights = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(sources); i++)
+	{
+		struct pcf85063a_time_source *source = sources[i];
+		int64_t offset;
+		uint64_t u, weight;
+
+		if (!source || !source->valid || !source->last.healthy ||
+		    now - source->last.uptime_ms > CONFIG_PCF85063A_TIME_SOURCE_MAX_AGE_S * MSEC_PER_SEC)
+		{
+			continue;
+		}
+
+		u = MAX(projected_uncertainty(&source->last, source->drift_ppm, now), 1);
+		offset = source->last.epoch_ms + (now - source->last.uptime_ms) - result.epoch_ms;
+
+		/* Disagreeing sources are outliers, not votes */
+		if (offset > (int64_t)(u + top_u) || -offset > (int64_t)(u + top_u))
+		{
+			LOG_DBG("%s disagrees by %lld ms.", source->name, offset);
+			continue;
+		}
+
+		weight = (1ULL << 32) / (u * u);
+		sum += offset * (int64_t)weight;
+		weights += weight;
+	}
+
+	if (weights)
+	{
+		result.epoch_ms += sum / (int64_t)weights;
+	}
+#endif
+
+	key = k_spin_lock(&best_lock);
+	best = result;
+	best_drift_ppm = top->drift_ppm;
+	best_source = top;
+	k_spin_unlock(&best_lock, key);
+
+	return 0;
+}
+
+int pcf85063a_time_source_register(struct pcf85063a_time_source *source)
+{
+	int ret = -ENOMEM;
+
+	k_mutex_lock(&sources_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sources); i++)
+	{
+		if (sources[i] == source)
+		{
+			ret = -EALREADY;
+			break;
+		}
+
+		if (!sources[i])
+		{
+			source->valid = false;
+			sources[i] = source;
+			ret = 0;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&sources_lock);
+
+	return ret;
+}
+
+int pcf85063a_time_source_submit(struct pcf85063a_time_source *source,
+				 const struct pcf85063a_time_sample *sample)
+{
+	k_mutex_lock(&sources_lock, K_FOREVER);
+
+	source->last = *sample;
+	source->valid = true;
+	rank();
+
+	k_mutex_unlock(&sources_lock);
+
+	return 0;
+}
+
+int pcf85063a_time_source_refresh(void)
+{
+	struct pcf85063a_time_source *pulled[ARRAY_SIZE(sources)];
+	struct pcf85063a_time_sample samples[ARRAY_SIZE(sources)];
+	int results[ARRAY_SIZE(sources)];
+	size_t count = 0;
+	int ret;
+
+	k_mutex_lock(&sources_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sources); i++)
+	{
+		if (sources[i] && sources[i]->read)
+		{
+			pulled[count++] = sources[i];
+		}
+	}
+
+	k_mutex_unlock(&sources_lock);
+
+	// Reads can poll for an edge, keep them off the lock submitters wait on
+	for (size_t i = 0; i < count; i++)
+	{
+		results[i] = pulled[i]->read(pulled[i], &samples[i]);
+		if (results[i])
+		{
+			LOG_DBG("%s unavailable. (err %i)", pulled[i]->name, results[i]);
+		}
+	}
+
+	k_mutex_lock(&sources_lock, K_FOREVER);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (results[i] == 0)
+		{
+			pulled[i]->last = samples[i];
+			pulled[i]->valid = true;
+		}
+	}
+
+	ret = rank();
+
+	k_mutex_unlock(&sources_lock);
+
+	return ret;
+}
+
+int pcf85063a_time_get(struct pcf85063a_time_sample *now)
+{
+	k_spinlock_key_t key = k_spin_lock(&best_lock);
+	int64_t uptime = k_uptime_get();
+
+	if (!best_source)
+	{
+		k_spin_unlock(&best_lock, key);
+		return -EAGAIN;
+	}
+
+	now->epoch_ms = best.epoch_ms + (uptime - best.uptime_ms);
+	now->uptime_ms = uptime;
+	now->uncertainty_ms = (uint32_t)MIN(projected_uncertainty(&best, best_drift_ppm, uptime),
+					    UINT32_MAX);
+	now->healthy = true;
+
+	k_spin_unlock(&best_lock, key);
+
+	return 0;
+}
+
+const struct pcf85063a_time_source *pcf85063a_time_best_source(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&best_lock);
+	const struct pcf85063a_time_source *source = best_source;
+
+	k_spin_unlock(&best_lock, key);
+
+	return source;
+}
+
+/* The RTC itself, answered from the anchor */
+static int rtc_read(struct pcf85063a_time_source *source, struct pcf85063a_time_sample *sample)
+{
+	const struct device *rtc = RTC;
+	struct pcf85063a_anchor anchor;
+	uint32_t uncertainty = CONFIG_PCF85063A_TIME_SOURCE_RTC_UNCERTAINTY_MS;
+	int ret;
+
+	ARG_UNUSED(source);
+
+	/* One burst read while the anchor is recent */
+	ret = pcf85063a_sync_anchor(rtc);
+	if (ret)
+	{
+		return ret;
+	}
+
+	ret = pcf85063a_get_anchor(rtc, &anchor);
+	if (ret)
+	{
+		return ret;
+	}
+
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+	struct pcf85063a_sync_stats stats;
+
+	/* Once compared against a reference the last offset is a better bound */
+	pcf85063a_get_sync_stats(rtc, &stats);
+	if (stats.references)
+	{
+		uncertainty = MIN(uncertainty, (uint32_t)abs(stats.last_offset_ms) +
+						       CONFIG_PCF85063A_EDGE_POLL_MS);
+	}
+#endif
+
+	sample->epoch_ms = anchor.epoch * MSEC_PER_SEC;
+	sample->uptime_ms = k_ticks_to_ms_floor64(anchor.uptime_ticks);
+	sample->uncertainty_ms = uncertainty;
+#ifdef CONFIG_PCF85063A_HEALTH
+	sample->healthy = pcf85063a_get_health(rtc) == PCF85063A_HEALTH_OK;
+#else
+	sample->healthy = true;
+#endif
+
+	return 0;
+}
+
+static struct pcf85063a_time_source rtc_source = {
+	.name = "pcf85063a",
+	.read = rtc_read,
+	.drift_ppm = CONFIG_PCF85063A_TIME_SOURCE_RTC_PPM,
+};
+
+static void refresh_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+
+	pcf85063a_time_source_refresh();
+
+	k_work_schedule(dwork, K_SECONDS(CONFIG_PCF85063A_TIME_SOURCE_REFRESH_S));
+}
+
+static K_WORK_DELAYABLE_DEFINE(refresh_work, refresh_handler);
+
+static int pcf85063a_time_source_init(void)
+{
+	if (device_is_ready(RTC))
+	{
+		pcf85063a_time_source_register(&rtc_source);
+	}
+
+	/* Edge polling can take a second, keep it out of boot */
+	k_work_schedule(&refresh_work, K_NO_WAIT);
+
+	return 0;
+}
+
+SYS_INIT(pcf85063a_time_source_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
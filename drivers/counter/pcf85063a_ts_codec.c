@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_ts_codec.h>
+
+#define VARINT_MAX_LEN 10
+
+static size_t varint_put(uint8_t *out, uint64_t value)
+{
+	size_t len = 0;
+
+	while (value >= 0x80)
+	{
+		out[len++] = (uint8_t)value | 0x80;
+		value >>= 7;
+	}
+
+	out[len++] = (uint8_t)value;
+
+	return len;
+}
+
+static int varint_get(const uint8_t *in, size_t avail, uint64_t *value, size_t *used)
+{
+	uint64_t result = 0;
+
+	for (size_t i = 0; i < MIN(avail, VARINT_MAX_LEN); i++)
+	{
+		result |= (uint64_t)(in[i] & 0x7f) << (7 * i);
+
+		if (!(in[i] & 0x80))
+		{
+			*value = result;
+			*used = i + 1;
+			return 0;
+		}
+	}
+
+	return avail < VARINT_MAX_LEN ? -ENODATA : -EBADMSG;
+}
+
+static uint64_t zigzag(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+int pcf85063a_ts_encoder_init(struct pcf85063a_ts_encoder *enc, uint8_t *buf, size_t size,
+			      uint32_t unit_ns, uint16_t anchor_interval,
+			      struct pcf85063a_ts_index_entry *index, size_t index_size)
+{
+	if (unit_ns == 0)
+	{
+		return -EINVAL;
+	}
+
+	*enc = (struct pcf85063a_ts_encoder){
+		.unit_ns = unit_ns,
+		.anchor_interval = MAX(anchor_interval, 1),
+		.index = index,
+		.index_size = index_size,
+	};
+
+	pcf85063a_ts_encoder_set_buffer(enc, buf, size);
+
+	return 0;
+}
+
+void pcf85063a_ts_encoder_set_buffer(struct pcf85063a_ts_encoder *enc, uint8_t *buf, size_t size)
+{
+	enc->buf = buf;
+	enc->size = size;
+	enc->len = 0;
+	enc->records = 0;
+	enc->index_len = 0;
+
+	/* Every buffer must decode on its own */
+	enc->since_anchor = enc->anchor_interval;
+}
+
+int pcf85063a_ts_encode(struct pcf85063a_ts_encoder *enc, int64_t timestamp_ns)
+{
+	uint8_t tmp[VARINT_MAX_LEN];
+	int64_t value = timestamp_ns / enc->unit_ns;
+	bool anchor = enc->since_anchor >= enc->anchor_interval;
+	size_t len;
+
+	if (anchor)
+	{
+		len = varint_put(tmp, (zigzag(value) << 1) | 1);
+	}
+	else
+	{
+		len = varint_put(tmp, zigzag(value - enc->prev) << 1);
+	}
+
+	if (enc->len + len > enc->size)
+	{
+		return -ENOMEM;
+	}
+
+	if (anchor)
+	{
+		if (enc->index && enc->index_len < enc->index_size)
+		{
+			enc->index[enc->index_len].record = enc->records;
+			enc->index[enc->index_len].offset = enc->len;
+			enc->index_len++;
+		}
+
+		enc->since_anchor = 0;
+	}
+
+	memcpy(&enc->buf[enc->len], tmp, len);
+	enc->len += len;
+	enc->since_anchor++;
+	enc->records++;
+	enc->prev = value;
+
+	return 0;
+}
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+int pcf85063a_ts_encode_now(struct pcf85063a_ts_encoder *enc, const struct device *dev)
+{
+	int64_t ticks;
+	int ret = pcf85063a_get_realtime_ticks(dev, &ticks);
+
+	if (ret)
+	{
+		return ret;
+	}
+
+	return pcf85063a_ts_encode(enc, pcf85063a_realtime_ticks_to_ns(ticks));
+}
+#endif
+
+int pcf85063a_ts_decoder_init(struct pcf85063a_ts_decoder *dec, const uint8_t *buf, size_t len,
+			      uint32_t unit_ns)
+{
+	if (unit_ns == 0)
+	{
+		return -EINVAL;
+	}
+
+	*dec = (struct pcf85063a_ts_decoder){
+		.buf = buf,
+		.len = len,
+		.unit_ns = unit_ns,
+	};
+
+	return 0;
+}
+
+int pcf85063a_ts_decode(struct pcf85063a_ts_decoder *dec, int64_t *timestamp_ns)
+{
+	uint64_t raw;
+	size_t used;
+	int ret;
+
+	if (dec->pos >= dec->len)
+	{
+		return -ENODATA;
+	}
+
+	ret = varint_get(&dec->buf[dec->pos], dec->len - dec->pos, &raw, &used);
+	if (ret)
+	{
+		return ret == -ENODATA ? -EBADMSG : ret;
+	}
+
+	if (raw & 1)
+	{
+		dec->prev = unzigzag(raw >> 1);
+		dec->anchored = true;
+	}
+	else if (dec->anchored)
+	{
+		dec->prev += unzigzag(raw >> 1);
+	}
+	else
+	{
+		/* A delta with nothing to apply it to */
+		return -EBADMSG;
+	}
+
+	dec->pos += used;
+	dec->record++;
+	*timestamp_ns = dec->prev * dec->unit_ns;
+
+	return 0;
+}
+
+int pcf85063a_ts_seek(struct pcf85063a_ts_decoder *dec, const struct pcf85063a_ts_index_entry *index,
+		      size_t index_len, uint32_t record)
+{
+	size_t lo = 0, hi = index_len;
+	int64_t skipped;
+	int ret;
+
+	if (index_len == 0 || index[0].record > record)
+	{
+		return -EINVAL;
+	}
+
+	/* Last anchor at or before the record */
+	while (hi - lo > 1)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (index[mid].record <= record)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	dec->pos = index[lo].offset;
+	dec->record = index[lo].record;
+	dec->anchored = false;
+
+	while (dec->record < record)
+	{
+		ret = pcf85063a_ts_decode(dec, &skipped);
+		if (ret)
+		{
+			return ret;
+		}
+	}
+
+	return 0;
+}
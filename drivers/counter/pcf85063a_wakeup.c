@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Coalesced wakeups. Every request is a window from its deadline to its
+ * deadline plus slack. The countdown is aimed at the end of the earliest
+ * window, and when it fires every request whose window has opened runs.
+ * Nearby requests with enough slack therefore share a single wake.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/counter.h>
+#include <zephyr/sys/util.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_wakeup.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pcf85063a, CONFIG_PCF85063A_LOG_LEVEL);
+
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+static struct pcf85063a_wakeup *pending[CONFIG_PCF85063A_WAKEUP_MAX];
+static K_MUTEX_DEFINE(lock);
+
+/* Uptime the countdown is set to expire at */
+static int64_t armed_ms;
+static bool armed;
+
+/* Handlers are running, they reschedule and the countdown is written once after */
+static bool expiring;
+
+static struct pcf85063a_wakeup_stats stats;
+
+/* Countdown source clock periods in microseconds, finest first */
+static const struct
+{
+	uint8_t freq;
+	uint32_t period_us;
+} sources[] = {
+	{PCF85063A_TIMER_MODE_FREQ_64, USEC_PER_SEC / 64},
+	{PCF85063A_TIMER_MODE_FREQ_1, USEC_PER_SEC},
+	{PCF85063A_TIMER_MODE_FREQ_1_60, 60 * USEC_PER_SEC},
+};
+
+static void expire(bool rtc);
+
+static void expire_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	expire(false);
+}
+
+static K_WORK_DEFINE(expire_work, expire_work_handler);
+
+static void countdown_fired(const struct device *dev, uint8_t chan_id, uint32_t ticks,
+			    void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(chan_id);
+	ARG_UNUSED(ticks);
+	ARG_UNUSED(user_data);
+
+	expire(true);
+}
+
+/* Aim the countdown at the end of the earliest window. Called with lock held. */
+static int program_nearest(int64_t now)
+{
+	int64_t soft = INT64_MAX, hard = INT64_MAX;
+	uint64_t remaining_us, value;
+	size_t i;
+	int ret;
+
+	if (expiring)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pending); i++)
+	{
+		struct pcf85063a_wakeup *wakeup = pending[i];
+
+		if (wakeup && wakeup->deadline_ms + wakeup->slack_ms < hard)
+		{
+			soft = wakeup->deadline_ms;
+			hard = wakeup->deadline_ms + wakeup->slack_ms;
+		}
+	}
+
+	if (hard == INT64_MAX)
+	{
+		if (armed)
+		{
+			armed = false;
+			return counter_cancel_channel_alarm(RTC, 0);
+		}
+
+		return 0;
+	}
+
+	// The wake already programmed lands inside the earliest window
+	if (armed && armed_ms >= soft && armed_ms <= hard)
+	{
+		return 0;
+	}
+
+	if (hard <= now)
+	{
+		k_work_submit(&expire_work);
+		return 0;
+	}
+
+	// Finest source clock that covers the wait in 255 periods
+	remaining_us = (uint64_t)(hard - now) * USEC_PER_MSEC;
+	for (i = 0; i < ARRAY_SIZE(sources) - 1; i++)
+	{
+		if (remaining_us < (uint64_t)sources[i].period_us * (UINT8_MAX + 1))
+		{
+			break;
+		}
+	}
+
+	// Round down so the wake is not late, unless that would be early for the
+	// window. Only windows narrower than a period are then missed, by less.
+	value = remaining_us / sources[i].period_us;
+	if (now + (int64_t)(value * sources[i].period_us / USEC_PER_MSEC) < soft)
+	{
+		value++;
+	}
+	value = CLAMP(value, 1, UINT8_MAX);
+
+	// -EBUSY if someone else armed the countdown, the driver does not share it
+	ret = pcf85063a_set_countdown(RTC, sources[i].freq, (uint8_t)value, countdown_fired, NULL);
+	if (ret)
+	{
+		LOG_ERR("Unable to arm RTC wakeup. (err %i)", ret);
+		armed = false;
+		return ret;
+	}
+
+	armed = true;
+	armed_ms = now + (int64_t)(value * sources[i].period_us / USEC_PER_MSEC);
+	stats.programs++;
+
+	return 0;
+}
+
+static void expire(bool rtc)
+{
+	struct pcf85063a_wakeup *due[CONFIG_PCF85063A_WAKEUP_MAX];
+	size_t count = 0;
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (rtc)
+	{
+		armed = false;
+		stats.wakes++;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(pending); i++)
+	{
+		struct pcf85063a_wakeup *wakeup = pending[i];
+
+		if (wakeup && wakeup->deadline_ms <= now)
+		{
+			due[count++] = wakeup;
+			pending[i] = NULL;
+		}
+	}
+
+	stats.fired += count;
+	expiring = count > 0;
+
+	k_mutex_unlock(&lock);
+
+	/* Run outside the lock so handlers can reschedule */
+	for (size_t i = 0; i < count; i++)
+	{
+		if (due[i]->handler)
+		{
+			due[i]->handler(due[i]);
+		}
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+	expiring = false;
+	program_nearest(k_uptime_get());
+	k_mutex_unlock(&lock);
+}
+
+int pcf85063a_wakeup_schedule(struct pcf85063a_wakeup *wakeup, int64_t deadline_ms,
+			      uint32_t slack_ms)
+{
+	struct pcf85063a_wakeup **slot = NULL;
+	int ret;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(pending); i++)
+	{
+		if (pending[i] == wakeup)
+		{
+			slot = &pending[i];
+			break;
+		}
+
+		if (!pending[i] && !slot)
+		{
+			slot = &pending[i];
+		}
+	}
+
+	if (!slot)
+	{
+		k_mutex_unlock(&lock);
+		return -ENOMEM;
+	}
+
+	wakeup->deadline_ms = deadline_ms;
+	wakeup->slack_ms = slack_ms;
+	*slot = wakeup;
+	stats.requests++;
+
+	ret = program_nearest(k_uptime_get());
+
+	k_mutex_unlock(&lock);
+
+	return ret;
+}
+
+int pcf85063a_wakeup_cancel(struct pcf85063a_wakeup *wakeup)
+{
+	int ret = 0;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(pending); i++)
+	{
+		if (pending[i] == wakeup)
+		{
+			pending[i] = NULL;
+			ret = program_nearest(k_uptime_get());
+			break;
+		}
+	}
+
+	k_mutex_unlock(&lock);
+
+	return ret;
+}
+
+int pcf85063a_wakeup_get_stats(struct pcf85063a_wakeup_stats *out)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&lock);
+
+	return 0;
+}
+
+void pcf85063a_wakeup_reset_stats(void)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+	memset(&stats, 0, sizeof(stats));
+	k_mutex_unlock(&lock);
+}
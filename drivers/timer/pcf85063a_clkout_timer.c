@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * System clock driver for boards that feed the PCF85063A CLKOUT into a low
+ * power MCU counter. CLKOUT defaults to 32.768 kHz at power on, so the kernel
+ * can start on it before I2C is up; the RTC driver keeps the COF bits there.
+ *
+ * Cycles are accumulated from the counter on every read, so timeouts are
+ * capped at half a counter wrap to never miss one.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/counter.h>
+#include <zephyr/drivers/timer/system_timer.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys_clock.h>
+
+#include <errno.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#define COUNTER DEVICE_DT_GET(DT_CHOSEN(pcf85063a_clkout_counter))
+#define RTC DEVICE_DT_GET_ONE(nxp_pcf85063a)
+
+#define CYC_PER_TICK (CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC / CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+
+/* A rounded CYC_PER_TICK would run kernel time fast or slow */
+BUILD_ASSERT(CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC % CONFIG_SYS_CLOCK_TICKS_PER_SEC == 0,
+	     "SYS_CLOCK_TICKS_PER_SEC must divide the 32768 Hz CLKOUT");
+
+/* Don't program an alarm closer than this, the counter may already be past it */
+#define MIN_DELAY_CYC 2
+
+/* Tick boundaries tried when the counter reports the alarm as late */
+#define SET_ALARM_TRIES 4
+
+static const struct device *const counter = COUNTER;
+
+static struct k_spinlock lock;
+
+/* Counter wrap period in cycles */
+static uint64_t wrap;
+
+/* Cycles accumulated up to last_raw */
+static uint64_t cycles;
+static uint32_t last_raw;
+
+/* Cycle count of the last announced tick */
+static uint64_t announced;
+
+static uint32_t max_ticks;
+
+/* Cycles the counter missed while it was stopped, added by pcf85063a_clkout_timer_skip() */
+static uint64_t skipped;
+
+static uint64_t cycles_now(void)
+{
+	uint32_t raw;
+
+	counter_get_value(counter, &raw);
+
+	cycles += raw >= last_raw ? raw - last_raw : raw + wrap - last_raw;
+	last_raw = raw;
+
+	return cycles + skipped;
+}
+
+static int set_alarm(uint64_t now, uint32_t ticks);
+
+static void alarm_handler(const struct device *dev, uint8_t chan_id, uint32_t ticks,
+			  void *user_data)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint64_t now = cycles_now();
+	uint32_t elapsed = (now - announced) / CYC_PER_TICK;
+
+	ARG_UNUSED(dev);
+	ARG_UNUSED(chan_id);
+	ARG_UNUSED(ticks);
+	ARG_UNUSED(user_data);
+
+	announced += (uint64_t)elapsed * CYC_PER_TICK;
+
+	if (!IS_ENABLED(CONFIG_TICKLESS_KERNEL))
+	{
+		set_alarm(now, 1);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	sys_clock_announce(elapsed);
+}
+
+/*
+ * Program the alarm for the tick boundary ticks after the last announced one.
+ * Counter drivers refuse to arm a channel twice, so the old alarm is dropped
+ * first. A target the counter has passed by the time it is written is moved
+ * to the next tick boundary rather than left unprogrammed.
+ */
+static int set_alarm(uint64_t now, uint32_t ticks)
+{
+	struct counter_alarm_cfg alarm = {
+		.callback = alarm_handler,
+	};
+	uint64_t target = announced +
+			  ((now - announced) / CYC_PER_TICK + ticks) * (uint64_t)CYC_PER_TICK;
+	int ret;
+
+	ret = counter_cancel_channel_alarm(counter, 0);
+	if (ret)
+	{
+		return ret;
+	}
+
+	for (int tries = 0; tries < SET_ALARM_TRIES; tries++)
+	{
+		while (target < now + MIN_DELAY_CYC)
+		{
+			target += CYC_PER_TICK;
+		}
+
+		alarm.ticks = (uint32_t)(target - now);
+		ret = counter_set_channel_alarm(counter, 0, &alarm);
+		if (ret != -ETIME)
+		{
+			break;
+		}
+
+		// Late by the time it reached the counter, try the next boundary
+		now = cycles_now();
+		target += CYC_PER_TICK;
+	}
+
+	__ASSERT(ret == 0, "Unable to set clock alarm (err %i)", ret);
+
+	return ret;
+}
+
+void sys_clock_set_timeout(int32_t ticks, bool idle)
+{
+	ARG_UNUSED(idle);
+
+	if (!IS_ENABLED(CONFIG_TICKLESS_KERNEL))
+	{
+		return;
+	}
+
+	ticks = ticks == K_TICKS_FOREVER ? (int32_t)max_ticks : CLAMP(ticks, 1, (int32_t)max_ticks);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	set_alarm(cycles_now(), ticks);
+
+	k_spin_unlock(&lock, key);
+}
+
+uint32_t sys_clock_elapsed(void)
+{
+	if (!IS_ENABLED(CONFIG_TICKLESS_KERNEL))
+	{
+		return 0;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint32_t elapsed = (cycles_now() - announced) / CYC_PER_TICK;
+
+	k_spin_unlock(&lock, key);
+
+	return elapsed;
+}
+
+uint32_t sys_clock_cycle_get_32(void)
+{
+	return (uint32_t)sys_clock_cycle_get_64();
+}
+
+uint64_t sys_clock_cycle_get_64(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint64_t now = cycles_now();
+
+	k_spin_unlock(&lock, key);
+
+	return now;
+}
+
+static int sys_clock_driver_init(void)
+{
+	int ret;
+
+	if (!device_is_ready(counter))
+	{
+		return -ENODEV;
+	}
+
+	if (counter_get_frequency(counter) != CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC)
+	{
+		return -EINVAL;
+	}
+
+	wrap = (uint64_t)counter_get_top_value(counter) + 1;
+	max_ticks = (wrap / 2) / CYC_PER_TICK;
+
+	ret = counter_start(counter);
+	if (ret)
+	{
+		return ret;
+	}
+
+	counter_get_value(counter, &last_raw);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	ret = set_alarm(cycles, IS_ENABLED(CONFIG_TICKLESS_KERNEL) ? max_ticks : 1);
+
+	k_spin_unlock(&lock, key);
+
+	return ret;
+}
+
+SYS_INIT(sys_clock_driver_init, PRE_KERNEL_2, CONFIG_SYSTEM_CLOCK_INIT_PRIORITY);
+
+void pcf85063a_clkout_timer_skip(uint64_t skip)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	skipped += skip;
+
+	// The alarm handler announces the gap, the only place ticks are announced
+	set_alarm(cycles_now(), 1);
+
+	k_spin_unlock(&lock, key);
+}
+
+int pcf85063a_clkout_time(struct timespec *ts)
+{
+	struct pcf85063a_anchor anchor;
+	int64_t ns;
+	int ret;
+
+	ret = pcf85063a_get_anchor(RTC, &anchor);
+	if (ret)
+	{
+		return ret;
+	}
+
+	ns = k_ticks_to_ns_floor64(k_uptime_ticks() - anchor.uptime_ticks);
+
+	ts->tv_sec = anchor.epoch + ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+
+	return 0;
+}
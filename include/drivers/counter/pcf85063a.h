@@ -9,6 +9,8 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/counter.h>
+#include <zephyr/drivers/gpio.h>
 #include <time.h>
 
 #define PCF85063A_BCD_UPPER_SHIFT 4
@@ -20,6 +22,8 @@
 #define PCF85063A_CTRL1_EXT_TEST BIT(7)
 #define PCF85063A_CTRL1_STOP BIT(5)
 #define PCF85063A_CTRL1_SR BIT(4)
+/* Written whole, SR only takes effect as part of this pattern */
+#define PCF85063A_CTRL1_SOFT_RESET 0x58
 #define PCF85063A_CTRL1_CIE BIT(2)
 #define PCF85063A_CTRL1_12_24 BIT(1)
 #define PCF85063A_CTRL1_CAP_SEL BIT(0)
@@ -32,6 +36,7 @@
 #define PCF85063A_CTRL2_TF BIT(3)
 
 /* CLKOUT frequency selection */
+#define PCF85063A_CTRL2_COF_MASK 0x7
 #define PCF85063A_CTRL2_COF_32K 0x0
 #define PCF85063A_CTRL2_COF_16K 0x1
 #define PCF85063A_CTRL2_COF_8K 0x2
@@ -105,7 +110,7 @@
 #define PCF85063A_HOUR_ALARM_AM_PM BIT(5)
 
 #define PCF85063A_DAY_ALARM 0x0e
-#define PCF85063A_DAY_ALARM_EN BIT_MASK(7)
+#define PCF85063A_DAY_ALARM_EN BIT(7)
 
 #define PCF85063A_WEEKDAY_ALARM 0x0f
 #define PCF85063A_WEEKDAY_ALARM_EN BIT(7)
@@ -113,7 +118,7 @@
 /* Timer registers */
 #define PCF85063A_TIMER_VALUE 0x10
 #define PCF85063A_TIMER_MODE 0x11
-#define PCF85063A_TIMER_MODE_FREQ_MASK BIT(4) | BIT(3)
+#define PCF85063A_TIMER_MODE_FREQ_MASK (BIT(4) | BIT(3))
 #define PCF85063A_TIMER_MODE_FREQ_SHIFT 3
 #define PCF85063A_TIMER_MODE_FREQ_4K 0x0
 #define PCF85063A_TIMER_MODE_FREQ_64 0x1
@@ -127,9 +132,188 @@
 #define PCF85063A_CAP_VALUE_7PF	0
 #define PCF85063A_CAP_VALUE_12_5PF	1
 
+/* RTC seconds edge and the kernel uptime at which it was seen */
+struct pcf85063a_anchor
+{
+	/* RTC time in seconds since the Unix epoch, just after the edge */
+	int64_t epoch;
+	/* k_uptime_ticks() at the edge */
+	int64_t uptime_ticks;
+};
+
+/* Reference time offered to pcf85063a_ingest_reference() */
+struct pcf85063a_reference
+{
+	/* Wall time in milliseconds since the Unix epoch */
+	int64_t epoch_ms;
+	/* k_uptime_get() at which epoch_ms was valid */
+	int64_t uptime_ms;
+	/* How far off epoch_ms may be, in milliseconds */
+	uint32_t uncertainty_ms;
+};
+
+struct pcf85063a_sync_stats
+{
+	/* References ingested */
+	uint32_t references;
+	/* References within tolerance that did not write the chip */
+	uint32_t suppressed;
+	/* Time writes issued to the chip */
+	uint32_t writes;
+	/* Time writes extrapolated over a day of uptime */
+	uint32_t writes_per_day;
+	/* Reference minus RTC at the last compared edge */
+	int32_t last_offset_ms;
+	/* Estimated RTC rate error, positive when running fast */
+	int32_t drift_ppb;
+};
+
+typedef void (*pcf85063a_calendar_alarm_callback_t)(const struct device *dev, void *user_data);
+
+/* Alarm sources, also the k_event bit numbers and k_poll_signal results */
+enum pcf85063a_alarm_source
+{
+	PCF85063A_ALARM_COUNTDOWN,
+	PCF85063A_ALARM_CALENDAR,
+	PCF85063A_ALARM_SOURCES,
+};
+
+/* Called from the INT pin ISR with the uptime the pulse was seen at */
+typedef void (*pcf85063a_periodic_callback_t)(const struct device *dev, int64_t uptime_ticks,
+					      void *user_data);
+
+enum pcf85063a_health
+{
+	/* No time read yet */
+	PCF85063A_HEALTH_UNKNOWN,
+	PCF85063A_HEALTH_OK,
+	/* OS flag set, the time is not valid */
+	PCF85063A_HEALTH_OSC_STOPPED,
+	/* Seconds did not advance while uptime did */
+	PCF85063A_HEALTH_OSC_STUCK,
+	/* Seconds advanced at a rate uptime disagrees with */
+	PCF85063A_HEALTH_TIME_SKEW,
+	/* Time registers out of range or not BCD */
+	PCF85063A_HEALTH_IMPLAUSIBLE,
+	/* Reads fail or return an idle bus */
+	PCF85063A_HEALTH_BUS_STUCK,
+};
+
+/* Called from the context of the read that changed the health state */
+typedef void (*pcf85063a_health_callback_t)(const struct device *dev,
+					    enum pcf85063a_health health, void *user_data);
+
+/* Per-instance constants, kept in ROM */
+struct pcf85063a_config
+{
+	/* Must be first, the counter API reads it through dev->config */
+	struct counter_config_info info;
+	struct i2c_dt_spec i2c;
+#ifdef CONFIG_PCF85063A_ALARM
+	/* INT pin, optional. Alarm callbacks need it. */
+	struct gpio_dt_spec int_gpio;
+#endif
+#ifdef CONFIG_PCF85063A_FACTORY_RESET
+	/* Devicetree defaults applied by pcf85063a_factory_reset() */
+	uint8_t reset_ctrl1;
+	uint32_t reset_clkout_hz;
+	uint8_t reset_offset;
+#endif
+};
+
+/* Per-instance mutable state */
 struct pcf85063a_data
 {
-	const struct i2c_dt_spec i2c;
+#ifdef CONFIG_PCF85063A_ANCHOR
+	/* RTC time at the last observed seconds edge and the uptime it occurred */
+	int64_t anchor_epoch;
+	int64_t anchor_uptime_ticks;
+	/* Wall time in ticks minus uptime in ticks, for cheap readers */
+	int64_t anchor_offset_ticks;
+	bool anchor_valid;
+	/* Odd while the anchor is being updated */
+	volatile uint32_t anchor_seq;
+	struct k_spinlock anchor_lock;
+#endif
+
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+	/* Reference sync and drift estimation */
+	int64_t sync_uptime_ms;
+	bool synced;
+	bool drift_valid;
+	int32_t drift_ppb;
+	int32_t last_offset_ms;
+	uint32_t references;
+	uint32_t suppressed;
+	uint32_t writes;
+#endif
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+	/* CTRL1 to OFFSET as on the chip, and with the setters' staged changes */
+	uint8_t cfg_shadow[PCF85063A_OFFSET + 1];
+	uint8_t cfg_staged[PCF85063A_OFFSET + 1];
+#endif
+
+#ifdef CONFIG_PCF85063A_SUBSECOND
+	/* Countdown phase, in 4096 Hz ticks, at which the seconds increment */
+	uint8_t subsec_edge_phase;
+	bool subsec_calibrated;
+	bool subsec_running;
+#endif
+
+#ifdef CONFIG_PCF85063A_HEALTH
+	/* Last time read that passed the checks, and its uptime */
+	enum pcf85063a_health health;
+	pcf85063a_health_callback_t health_callback;
+	void *health_user_data;
+	int64_t health_epoch;
+	int64_t health_uptime_ms;
+	bool health_seen;
+	uint8_t bus_errors;
+#endif
+
+#ifdef CONFIG_PCF85063A_FATTIME
+	/* FAT word from the last register read, its seconds and uptime */
+	uint32_t fat_base;
+	uint8_t fat_sec;
+	int64_t fat_uptime_ms;
+	bool fat_valid;
+	struct k_spinlock fat_lock;
+#endif
+
+#ifdef CONFIG_PCF85063A_ALARM
+	/* Countdown alarm channel */
+	const struct device *dev;
+	struct gpio_callback int_cb;
+	struct k_work work;
+	counter_alarm_callback_t alarm_callback;
+	void *alarm_user_data;
+	uint8_t alarm_ticks;
+	uint8_t alarm_freq;
+	bool alarm_armed;
+	bool alarm_pending;
+
+	/* Uptime at which the countdown expires, when known */
+	int64_t alarm_deadline_ticks;
+	bool alarm_deadline_valid;
+
+	/* Periodic pulse mode on the countdown, set while it is running */
+	pcf85063a_periodic_callback_t periodic_callback;
+	void *periodic_user_data;
+
+	/* Calendar alarm */
+	pcf85063a_calendar_alarm_callback_t calendar_callback;
+	void *calendar_user_data;
+	bool calendar_alarm_armed;
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+	/* Kernel objects raised on expiry, per source */
+	struct k_poll_signal *signal[PCF85063A_ALARM_SOURCES];
+	struct k_event *event;
+	/* Cycle counter at the last INT edge */
+	uint32_t int_cycles;
+#endif
+#endif
 };
 
 int pcf85063a_init(const struct device *dev);
@@ -142,10 +326,235 @@ int pcf85063a_init(const struct device *dev);
  * int pcf85063a_timer_en(bool enabled);
  */
 
+#ifdef CONFIG_PCF85063A_CAP_SEL
 int pcf85063a_set_cap_sel(const struct device *dev, uint8_t cap_value);
+#endif
+
+#ifdef CONFIG_PCF85063A_OFFSET
 int pcf85063a_set_offset_mode(const struct device *dev, uint8_t offset_mode_value);
 int pcf85063a_set_offset_value(const struct device *dev, uint8_t offset_value);
+#endif
+
+#ifdef CONFIG_PCF85063A_CONFIG_CACHE
+/*
+ * With the cache the setters above only stage their change. Write every
+ * changed register, one burst per run of adjacent ones.
+ */
+int pcf85063a_commit(const struct device *dev);
+#endif
+
 int pcf85063a_set_time(const struct device *dev, const struct tm *time);
 int pcf85063a_get_time(const struct device *dev, struct tm *time);
 
+#ifdef CONFIG_PCF85063A_FACTORY_RESET
+/* SECOND_ALARM through TIMER_MODE, then CTRL1 to OFFSET after the wrap */
+#define PCF85063A_RESET_BURST_LEN 10
+
+/*
+ * Software reset, then the devicetree defaults (quartz-load-femtofarads,
+ * clkout-frequency, nxp,offset) with alarms and timer off in one burst,
+ * checked with one burst read. The time registers keep running. elapsed_us,
+ * if not NULL, receives the time taken.
+ */
+int pcf85063a_factory_reset(const struct device *dev, uint32_t *elapsed_us);
+#endif
+
+#ifdef CONFIG_PCF85063A_HEALTH
+/*
+ * Clock health as judged from the time reads the driver already makes. No
+ * bus traffic of its own; the state only changes when something reads time.
+ */
+enum pcf85063a_health pcf85063a_get_health(const struct device *dev);
+void pcf85063a_set_health_callback(const struct device *dev, pcf85063a_health_callback_t callback,
+				   void *user_data);
+#endif
+
+#ifdef CONFIG_PCF85063A_ALARM
+/*
+ * Arm the countdown on channel 0 for value periods of the source clock freq
+ * (PCF85063A_TIMER_MODE_FREQ_*). The counter API alarm is this at 1 Hz.
+ * -EBUSY while the countdown is armed with another callback or is periodic.
+ */
+int pcf85063a_set_countdown(const struct device *dev, uint8_t freq, uint8_t value,
+			    counter_alarm_callback_t callback, void *user_data);
+
+/*
+ * Run the countdown continuously in pulse mode, every value periods of freq.
+ * The callback runs in ISR context on each pulse, without bus access. Needs
+ * int-gpios. Stop it with counter_cancel_channel_alarm(). -EBUSY while the
+ * countdown is armed with another callback.
+ */
+int pcf85063a_set_periodic(const struct device *dev, uint8_t freq, uint8_t value,
+			   pcf85063a_periodic_callback_t callback, void *user_data);
+
+/*
+ * Attach a callback to a countdown alarm that was already armed when the
+ * driver initialized, without touching the hardware. Returns -ENOENT when no
+ * alarm is armed. If it expired in the meantime the callback runs right away.
+ */
+int pcf85063a_attach_alarm(const struct device *dev, counter_alarm_callback_t callback,
+			   void *user_data);
+/*
+ * Calendar alarm on second, minute, hour and day of month of time, which uses
+ * the driver's struct tm conventions. The callback runs from the system work
+ * queue once the RTC reaches that time; it needs int-gpios.
+ */
+int pcf85063a_set_calendar_alarm(const struct device *dev, const struct tm *time,
+				 pcf85063a_calendar_alarm_callback_t callback, void *user_data);
+int pcf85063a_cancel_calendar_alarm(const struct device *dev);
+bool pcf85063a_calendar_alarm_armed(const struct device *dev);
+
+#ifdef CONFIG_PCF85063A_ALARM_SIGNAL
+/*
+ * Raise signal with the source as result whenever that source expires, or
+ * NULL to stop. Raised from the driver's work item before any callback runs,
+ * so a thread in k_poll() wakes without waiting on callbacks. Periodic
+ * pulses raise it from the INT pin ISR, ahead of the periodic callback.
+ */
+int pcf85063a_set_alarm_signal(const struct device *dev, enum pcf85063a_alarm_source source,
+			       struct k_poll_signal *signal);
+
+/* Post BIT(source) to event for every expiry, or NULL to stop. */
+int pcf85063a_set_alarm_event(const struct device *dev, struct k_event *event);
+
+/* k_cycle_get_32() at the last INT edge, for measuring wake latency */
+uint32_t pcf85063a_last_int_cycles(const struct device *dev);
+#endif
+
+/*
+ * Time left on the armed countdown, in countdown ticks at the active timer
+ * frequency and in microseconds. Either pointer may be NULL. When the arm
+ * time is known the answer comes from uptime without bus access; otherwise
+ * PCF85063A_TIMER_VALUE is read once. Returns -ENOENT when nothing is armed.
+ */
+int pcf85063a_get_alarm_remaining(const struct device *dev, uint32_t *ticks, uint64_t *us);
+#endif
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+/*
+ * Locate the next RTC seconds edge on the bus and record it as the anchor.
+ * Takes up to a second of polling, unless the anchor is younger than
+ * CONFIG_PCF85063A_ANCHOR_MAX_AGE_S and one burst read confirms it; that
+ * anchor is then kept as measured.
+ */
+int pcf85063a_sync_anchor(const struct device *dev);
+
+/* Last recorded anchor, no bus access. -EAGAIN if there is none. */
+int pcf85063a_get_anchor(const struct device *dev, struct pcf85063a_anchor *anchor);
+
+/*
+ * Wall time in kernel ticks since the Unix epoch, interpolated from the anchor
+ * with kernel uptime. No bus access, callable from any context.
+ */
+int pcf85063a_get_realtime_ticks(const struct device *dev, int64_t *ticks);
+
+/*
+ * Wall time in ticks minus uptime in ticks, as of the last anchor. For hot
+ * paths that add it to k_uptime_ticks() themselves; zero before any anchor.
+ */
+static inline int64_t pcf85063a_anchor_offset_ticks(const struct pcf85063a_data *data)
+{
+	uint32_t seq;
+	int64_t offset;
+
+	do
+	{
+		seq = data->anchor_seq;
+		compiler_barrier();
+		offset = data->anchor_offset_ticks;
+		compiler_barrier();
+	} while ((seq & 1) || seq != data->anchor_seq);
+
+	return offset;
+}
+
+/*
+ * Wall time ticks to nanoseconds. Whole seconds are split off first, at
+ * epoch scale a direct k_ticks_to_ns_floor64() overflows.
+ */
+static inline int64_t pcf85063a_realtime_ticks_to_ns(int64_t ticks)
+{
+	int64_t sec = ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+
+	return sec * NSEC_PER_SEC + k_ticks_to_ns_floor64(ticks - sec * CONFIG_SYS_CLOCK_TICKS_PER_SEC);
+}
+#endif
+
+#ifdef CONFIG_PCF85063A_SUBSECOND
+/*
+ * Run the countdown at 4096 Hz with auto-reload and locate its phase against
+ * the seconds edge, which takes up to a second. -EBUSY while an alarm owns
+ * the countdown.
+ */
+int pcf85063a_subsec_start(const struct device *dev);
+int pcf85063a_subsec_stop(const struct device *dev);
+
+/*
+ * RTC time to 1/4096 s from one burst of the time and timer registers. The
+ * kernel clock only picks which 1/32 s timer period the read fell in.
+ */
+int pcf85063a_subsec_get(const struct device *dev, struct timespec *ts);
+#endif
+
+#ifdef CONFIG_PCF85063A_FATTIME
+/*
+ * Current time as a FAT date/time word, packed straight from the BCD
+ * registers. The registers are read at most once a minute, in between the
+ * seconds field is advanced from uptime.
+ */
+int pcf85063a_get_fattime(const struct device *dev, uint32_t *fattime);
+#endif
+
+#ifdef CONFIG_PCF85063A_CLKOUT_TIMER
+/*
+ * Wall time from kernel uptime and the RTC anchor. The kernel runs off CLKOUT,
+ * so the two do not drift apart and no bus access is needed. Call
+ * pcf85063a_sync_anchor() once after boot and after every time write.
+ */
+int pcf85063a_clkout_time(struct timespec *ts);
+
+/*
+ * Add cycles the counter did not count while it was stopped, e.g. in a SoC
+ * state that powers it down. They are announced from the next clock alarm.
+ */
+void pcf85063a_clkout_timer_skip(uint64_t cycles);
+#endif
+
+#ifdef CONFIG_PCF85063A_PM_OFFLOAD
+struct pcf85063a_pm_stats
+{
+	/* Idle periods handed to the RTC countdown */
+	uint32_t offloads;
+	/* Entries into the deepest power state */
+	uint32_t deep_entries;
+	/* Time spent offloaded, measured by the RTC */
+	uint64_t offloaded_ms;
+	/* RTC elapsed minus kernel elapsed over the last offload, before correction */
+	int32_t last_error_ms;
+	int32_t max_error_ms;
+	/* Kernel time handed to the CLKOUT system timer for a stopped counter */
+	uint64_t corrected_ms;
+	/* Idle periods left to the kernel because the countdown was in use */
+	uint32_t declined;
+	/* RTC wakes that did not arrive in time */
+	uint32_t missed;
+	/* Charge saved against plain idle, in microamp seconds. 0 unless the
+	 * idle current is set above the deep current.
+	 */
+	uint64_t saved_uas;
+};
+
+int pcf85063a_pm_get_stats(struct pcf85063a_pm_stats *stats);
+#endif
+
+#ifdef CONFIG_PCF85063A_REFERENCE_SYNC
+/*
+ * Compare a reference time against the RTC at its seconds edge. The chip is
+ * only written when the offset exceeds CONFIG_PCF85063A_SYNC_TOLERANCE_MS plus
+ * the reference uncertainty; such offsets also feed the drift estimate.
+ */
+int pcf85063a_ingest_reference(const struct device *dev, const struct pcf85063a_reference *ref);
+int pcf85063a_get_sync_stats(const struct device *dev, struct pcf85063a_sync_stats *stats);
+#endif
+
 #endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_PCF85063A_H_ */
\ No newline at end of file
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_BUS_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_BUS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Estimated bus cost. Every byte is 9 clocks, every start or repeated start
+ * with its stop about 2 more, at CONFIG_PCF85063A_BUS_HZ, plus
+ * CONFIG_PCF85063A_BUS_OVERHEAD_US per transfer. Charge is that time at
+ * CONFIG_PCF85063A_BUS_ACTIVE_UA.
+ */
+struct pcf85063a_bus_usage
+{
+	uint32_t transfers;
+	/* Bytes on the wire, address bytes included */
+	uint32_t bytes;
+	/* Starts plus repeated starts */
+	uint32_t starts;
+	uint64_t busy_ns;
+	/* Picocoulombs, uA x us */
+	uint64_t charge_pc;
+};
+
+/*
+ * Tag transfers made by the calling thread from now on, so callers can be
+ * told apart. Returns the previous tag; the default is 0.
+ */
+uint8_t pcf85063a_bus_tag_set(uint8_t tag);
+
+/* Name reported for functions beyond CONFIG_PCF85063A_BUS_OPS */
+#define PCF85063A_BUS_OP_OTHER "other"
+
+/* Name charged for servicing the INT line, which no caller asked for */
+#define PCF85063A_BUS_OP_INT "interrupt"
+
+/*
+ * Usage per driver operation, by index from 0 until -ENOENT. op is the name
+ * of the public driver function the transfers were made for, internal
+ * helpers included. Once the table is full, further functions are summed in
+ * a last entry named PCF85063A_BUS_OP_OTHER.
+ */
+int pcf85063a_bus_usage_by_op(size_t index, const char **op, struct pcf85063a_bus_usage *usage);
+
+/* Usage by caller tag, below CONFIG_PCF85063A_BUS_TAGS */
+int pcf85063a_bus_usage_by_tag(uint8_t tag, struct pcf85063a_bus_usage *usage);
+
+/* Sum over all transfers, counted apart from the per operation table */
+void pcf85063a_bus_usage_total(struct pcf85063a_bus_usage *usage);
+
+void pcf85063a_bus_usage_reset(void);
+
+/* For the driver: account one transfer made by op and pass its result through */
+int pcf85063a_bus_charge(const char *op, uint32_t bytes, uint32_t starts, int ret);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_BUS_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_CALENDAR_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_CALENDAR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Proleptic Gregorian calendar arithmetic on day counts since 1970-01-01.
+ * Years are shifted to start in March, so the leap day is the last day of
+ * the year and no month or leap year table is needed. Every function is a
+ * fixed sequence of integer operations, no loops and no lookups, so any
+ * input, in range or not, costs the same and cannot index out of bounds.
+ *
+ * Months are 1-12 and days 1-31 here. The struct tm helpers convert from
+ * and to the usual tm_mon 0-11 and tm_year since 1900.
+ */
+
+#define PCF85063A_SECONDS_PER_DAY 86400
+
+/* Days in a 400 year era and from 0000-03-01 to 1970-01-01 */
+#define PCF85063A_DAYS_PER_ERA 146097
+#define PCF85063A_DAYS_TO_EPOCH 719468
+
+static inline bool pcf85063a_is_leap(int32_t year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static inline uint32_t pcf85063a_days_in_month(int32_t year, uint32_t month)
+{
+	/* 30 or 31 alternating, flipping after July, and February */
+	return month == 2 ? 28U + pcf85063a_is_leap(year) : 30 + ((month + (month > 7)) & 1);
+}
+
+/* Days since 1970-01-01 of year-month-day */
+static inline int32_t pcf85063a_days_from_civil(int32_t year, uint32_t month, uint32_t day)
+{
+	int32_t y = year - (month <= 2);
+	int32_t era = (y >= 0 ? y : y - 399) / 400;
+	uint32_t yoe = (uint32_t)(y - era * 400);
+	uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * PCF85063A_DAYS_PER_ERA + (int32_t)doe - PCF85063A_DAYS_TO_EPOCH;
+}
+
+/* Inverse of pcf85063a_days_from_civil() */
+static inline void pcf85063a_civil_from_days(int32_t days, int32_t *year, uint32_t *month,
+					     uint32_t *day)
+{
+	int32_t z = days + PCF85063A_DAYS_TO_EPOCH;
+	int32_t era = (z >= 0 ? z : z - (PCF85063A_DAYS_PER_ERA - 1)) / PCF85063A_DAYS_PER_ERA;
+	uint32_t doe = (uint32_t)(z - era * PCF85063A_DAYS_PER_ERA);
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / (PCF85063A_DAYS_PER_ERA - 1)) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+
+	*day = doy - (153 * mp + 2) / 5 + 1;
+	*month = mp < 10 ? mp + 3 : mp - 9;
+	*year = (int32_t)yoe + era * 400 + (*month <= 2);
+}
+
+/* 0 is Sunday, as in tm_wday and the WEEKDAYS register */
+static inline uint32_t pcf85063a_weekday(int32_t days)
+{
+	/* 1970-01-01 was a Thursday */
+	return (uint32_t)(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+/* Day of the year from 0, as in tm_yday */
+static inline uint32_t pcf85063a_yday(int32_t year, uint32_t month, uint32_t day)
+{
+	return (uint32_t)(pcf85063a_days_from_civil(year, month, day) -
+			  pcf85063a_days_from_civil(year, 1, 1));
+}
+
+/* Seconds since the Unix epoch. Months outside 0-11 carry into the year. */
+static inline int64_t pcf85063a_tm_to_epoch(const struct tm *time)
+{
+	int32_t mon = time->tm_mon;
+	int32_t carry = (mon >= 0 ? mon : mon - 11) / 12;
+	int32_t days = pcf85063a_days_from_civil(time->tm_year + 1900 + carry,
+						 (uint32_t)(mon - carry * 12) + 1, 1) +
+		       time->tm_mday - 1;
+
+	return (int64_t)days * PCF85063A_SECONDS_PER_DAY + time->tm_hour * 3600 +
+	       time->tm_min * 60 + time->tm_sec;
+}
+
+/* Broken down UTC time, including tm_wday and tm_yday */
+static inline void pcf85063a_epoch_to_tm(int64_t epoch, struct tm *time)
+{
+	int64_t days = (epoch >= 0 ? epoch : epoch - (PCF85063A_SECONDS_PER_DAY - 1)) /
+		       PCF85063A_SECONDS_PER_DAY;
+	int32_t sod = (int32_t)(epoch - days * PCF85063A_SECONDS_PER_DAY);
+	int32_t year;
+	uint32_t month, day;
+
+	pcf85063a_civil_from_days((int32_t)days, &year, &month, &day);
+
+	time->tm_sec = sod % 60;
+	time->tm_min = sod / 60 % 60;
+	time->tm_hour = sod / 3600;
+	time->tm_mday = (int)day;
+	time->tm_mon = (int)month - 1;
+	time->tm_year = year - 1900;
+	time->tm_wday = (int)pcf85063a_weekday((int32_t)days);
+	time->tm_yday = (int)pcf85063a_yday(year, month, day);
+	time->tm_isdst = 0;
+}
+
+/* Move time by seconds, either way, and normalise every field */
+static inline void pcf85063a_tm_add(struct tm *time, int64_t seconds)
+{
+	pcf85063a_epoch_to_tm(pcf85063a_tm_to_epoch(time) + seconds, time);
+}
+
+/* a minus b in seconds */
+static inline int64_t pcf85063a_tm_diff(const struct tm *a, const struct tm *b)
+{
+	return pcf85063a_tm_to_epoch(a) - pcf85063a_tm_to_epoch(b);
+}
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_CALENDAR_H_ */
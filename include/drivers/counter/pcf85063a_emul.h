@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_EMUL_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_EMUL_H_
+
+#include <zephyr/drivers/emul.h>
+
+/* Bus traffic seen by the emulator since the last reset */
+struct pcf85063a_emul_stats
+{
+	/* i2c_transfer() calls */
+	uint32_t transfers;
+	/* Messages within them, each costs a start and address byte */
+	uint32_t messages;
+	/* Bytes on the wire including address bytes */
+	uint32_t bus_bytes;
+	uint32_t bytes_read;
+	uint32_t bytes_written;
+	/* INT assertions */
+	uint32_t interrupts;
+	/* Time writes with a month or day the chip cannot count, left unapplied */
+	uint32_t invalid_dates;
+};
+
+void pcf85063a_emul_get_stats(const struct emul *target, struct pcf85063a_emul_stats *stats);
+void pcf85063a_emul_reset_stats(const struct emul *target);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_EMUL_H_ */
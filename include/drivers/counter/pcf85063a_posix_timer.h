@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_POSIX_TIMER_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_POSIX_TIMER_H_
+
+#include <signal.h>
+#include <time.h>
+
+/*
+ * CLOCK_REALTIME timers on the PCF85063A calendar alarm. Same signatures and
+ * errno conventions as timer_create() and friends, so ported code can map
+ * them with a #define. Only the nearest timer is programmed into the RTC.
+ *
+ * Expiry is resolved to the RTC second: a timer fires on the first RTC
+ * seconds edge at or after its expiry. SIGEV_THREAD notifications run on the
+ * system work queue, SIGEV_SIGNAL is not supported.
+ */
+int pcf85063a_timer_create(clockid_t clockid, struct sigevent *evp, timer_t *timerid);
+int pcf85063a_timer_settime(timer_t timerid, int flags, const struct itimerspec *value,
+			    struct itimerspec *ovalue);
+int pcf85063a_timer_gettime(timer_t timerid, struct itimerspec *value);
+int pcf85063a_timer_getoverrun(timer_t timerid);
+int pcf85063a_timer_delete(timer_t timerid);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_POSIX_TIMER_H_ */
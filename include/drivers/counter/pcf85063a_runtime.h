@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_RUNTIME_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_RUNTIME_H_
+
+#include <stdint.h>
+
+struct pcf85063a_runtime
+{
+	/* Seconds since provisioning, powered or not. Never goes back. */
+	uint64_t elapsed_s;
+	/* Seconds spent running, over every boot since provisioning */
+	uint64_t run_s;
+	/* Boots since provisioning, this one included */
+	uint32_t boots;
+};
+
+/*
+ * Counters as of now. Worked out from uptime and the RTC read at boot,
+ * without bus access. -EAGAIN before the meter has started.
+ */
+int pcf85063a_runtime_get(struct pcf85063a_runtime *runtime);
+
+/* Zero every counter and start over from now */
+int pcf85063a_runtime_provision(void);
+
+/*
+ * Read the RTC once and save the counters. Call before sys_poweroff() or a
+ * planned reboot, so the run time since the last periodic save is kept and
+ * the time spent off is measured from this moment.
+ */
+int pcf85063a_runtime_shutdown(void);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_RUNTIME_H_ */
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_SAMPLER_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_SAMPLER_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/atomic.h>
+
+/*
+ * Called from the system work queue after each fetch. timestamp_ns is the
+ * wall time of the RTC pulse that triggered it, seq counts pulses from 0 and
+ * skips those that arrived while the previous fetch was still running.
+ */
+typedef void (*pcf85063a_sampler_handler_t)(const struct device *sensor, int64_t timestamp_ns,
+					    uint32_t seq, int fetch_err, void *user_data);
+
+struct pcf85063a_sampler
+{
+	const struct device *rtc;
+	const struct device *sensor;
+	pcf85063a_sampler_handler_t handler;
+	void *user_data;
+
+	/* Private */
+	struct k_work work;
+	atomic_t pulses;
+	uint32_t handled;
+	uint32_t missed;
+	int64_t first_uptime_ticks;
+	int64_t first_ns;
+	uint64_t period_ns;
+};
+
+/*
+ * Fetch from sensor every value periods of freq, PCF85063A_TIMER_MODE_FREQ_64,
+ * _1 or _1_60. Timestamps count RTC periods from the first pulse, corrected
+ * by the drift estimate from reference sync when there is one, so no bus
+ * reads are spent on them. Fill in rtc, sensor and handler before calling.
+ */
+int pcf85063a_sampler_start(struct pcf85063a_sampler *sampler, uint8_t freq, uint8_t value);
+int pcf85063a_sampler_stop(struct pcf85063a_sampler *sampler);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_SAMPLER_H_ */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_SENSOR_TS_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_SENSOR_TS_H_
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <stdint.h>
+
+/*
+ * Wall time for RTIO sensor streams. Sensor drivers stamp their buffers
+ * with uptime in ns. These move such a stamp onto wall time through the RTC
+ * anchor, so buffered frames cost no bus access. Refresh the anchor with
+ * pcf85063a_sync_anchor() now and then to follow MCU clock drift.
+ *
+ * Drivers that stamp through the sensor clock API already get wall time
+ * with CONFIG_PCF85063A_SENSOR_CLOCK, their frames need no wrapper.
+ */
+
+/* Uptime ns, as in sensor_data_header, to ns since the Unix epoch. -EAGAIN without an anchor. */
+int pcf85063a_sensor_realtime_ns(const struct device *rtc, uint64_t uptime_ns,
+				 uint64_t *realtime_ns);
+
+/*
+ * decoder->decode() with the decoded header's base_timestamp_ns, and so
+ * every reading's offset from it, on wall time. Same return value. Without
+ * an anchor the frame keeps its uptime timestamp and -EAGAIN is stored in
+ * *ts_err, which may be NULL.
+ */
+int pcf85063a_sensor_decode(const struct device *rtc, const struct sensor_decoder_api *decoder,
+			    const uint8_t *buffer, struct sensor_chan_spec chan_spec, uint32_t *fit,
+			    uint16_t max_count, void *data_out, int *ts_err);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_SENSOR_TS_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_STREAM_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_STREAM_H_
+
+#include <zephyr/device.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Timestamps for a fixed rate sample stream. Sample n of a segment is at
+ * base + n * step, with step in 1/65536 ns so rounding does not accumulate.
+ * Realigning starts a new segment at the next sample, placed through a
+ * fresh RTC anchor.
+ */
+struct pcf85063a_stream
+{
+	const struct device *rtc;
+	/* Wall time and uptime of sample 0 of the segment, in ns */
+	int64_t base_ns;
+	int64_t base_uptime_ns;
+	/* Sample period in ns << 16, drift corrected */
+	uint64_t step;
+	/* Part of a ns past base_ns, in 1/65536 ns */
+	uint16_t frac;
+	/* Next sample after base_ns */
+	uint32_t index;
+};
+
+/*
+ * Start a stream at rate_hz whose sample clock runs drift_ppb fast, with
+ * sample 0 taken at first_uptime_ticks. Needs an anchor, which is captured
+ * if there is none yet.
+ */
+int pcf85063a_stream_start(struct pcf85063a_stream *stream, const struct device *rtc,
+			   uint32_t rate_hz, int32_t drift_ppb, int64_t first_uptime_ticks);
+
+/*
+ * Timestamps in ns since the Unix epoch for the next count samples. No bus
+ * access. One call may cover up to about 78 hours of samples.
+ */
+void pcf85063a_stream_fill(struct pcf85063a_stream *stream, int64_t *timestamps, size_t count);
+
+/*
+ * Refresh the anchor from the RTC seconds edge and start a new segment at the
+ * next sample. Call between batches. One burst read while the anchor is
+ * younger than CONFIG_PCF85063A_ANCHOR_MAX_AGE_S, up to a second of polling
+ * once it is older.
+ */
+int pcf85063a_stream_realign(struct pcf85063a_stream *stream);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_STREAM_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_TIME_SOURCE_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_TIME_SOURCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Wall time as seen by one source, or the published best of them */
+struct pcf85063a_time_sample
+{
+	/* Wall time in milliseconds since the Unix epoch */
+	int64_t epoch_ms;
+	/* k_uptime_get() at which epoch_ms was valid */
+	int64_t uptime_ms;
+	/* How far off epoch_ms may be at uptime_ms */
+	uint32_t uncertainty_ms;
+	/* The source trusts its own answer */
+	bool healthy;
+};
+
+struct pcf85063a_time_source;
+
+/* Pull a fresh sample. Runs on the system work queue, may block briefly. */
+typedef int (*pcf85063a_time_source_read_t)(struct pcf85063a_time_source *source,
+					    struct pcf85063a_time_sample *sample);
+
+struct pcf85063a_time_source
+{
+	const char *name;
+	/* Optional, sources that push with _submit() leave it NULL */
+	pcf85063a_time_source_read_t read;
+	/* Uncertainty growth as the sample ages, in ppm of its age */
+	uint32_t drift_ppm;
+
+	/* Private */
+	struct pcf85063a_time_sample last;
+	bool valid;
+};
+
+/*
+ * Sources are ranked by uncertainty projected to now, age included. Sources
+ * that are unhealthy or older than CONFIG_PCF85063A_TIME_SOURCE_MAX_AGE_S
+ * drop out. With CONFIG_PCF85063A_TIME_SOURCE_BLEND the best source is
+ * averaged with those that agree with it, weighted by inverse variance.
+ */
+int pcf85063a_time_source_register(struct pcf85063a_time_source *source);
+
+/* Hand over a sample, e.g. from network time, and re-rank. */
+int pcf85063a_time_source_submit(struct pcf85063a_time_source *source,
+				 const struct pcf85063a_time_sample *sample);
+
+/*
+ * Read every pulling source now and re-rank, -EAGAIN if none qualifies.
+ * Reads run outside the source lock, submitters are not held up by them.
+ * Also runs periodically.
+ */
+int pcf85063a_time_source_refresh(void);
+
+/*
+ * Best time projected to now, from the published cache. No bus access,
+ * callable from any context. -EAGAIN until some source has answered.
+ */
+int pcf85063a_time_get(struct pcf85063a_time_sample *now);
+
+/* Source currently ranked best, NULL if none */
+const struct pcf85063a_time_source *pcf85063a_time_best_source(void);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_TIME_SOURCE_H_ */
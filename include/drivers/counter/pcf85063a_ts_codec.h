@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_TS_CODEC_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_TS_CODEC_H_
+
+#include <zephyr/device.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compact timestamp stream. Each record is one varint whose low bit tells an
+ * absolute anchor (1) from a delta to the previous record (0). Both are
+ * zigzag coded, so timestamps before 1970 and steps backwards survive.
+ * Timestamps are quantized to unit_ns before coding, so deltas do not
+ * accumulate rounding error. An anchor is written every anchor_interval
+ * records and at the start of every buffer, so decoding can start at any
+ * anchor. A 1 ms cadence at microsecond units takes two bytes per record.
+ */
+
+/* Where an anchor sits in the stream, for seeking */
+struct pcf85063a_ts_index_entry
+{
+	uint32_t record;
+	uint32_t offset;
+};
+
+struct pcf85063a_ts_encoder
+{
+	uint8_t *buf;
+	size_t size;
+	size_t len;
+	uint32_t unit_ns;
+	uint16_t anchor_interval;
+	uint16_t since_anchor;
+	/* Records written to the current buffer */
+	uint32_t records;
+	int64_t prev;
+	/* Optional anchor index, filled as anchors are written */
+	struct pcf85063a_ts_index_entry *index;
+	size_t index_size;
+	size_t index_len;
+};
+
+struct pcf85063a_ts_decoder
+{
+	const uint8_t *buf;
+	size_t len;
+	size_t pos;
+	uint32_t unit_ns;
+	uint32_t record;
+	int64_t prev;
+	bool anchored;
+};
+
+/* -EINVAL for a unit_ns of 0 */
+int pcf85063a_ts_encoder_init(struct pcf85063a_ts_encoder *enc, uint8_t *buf, size_t size,
+			      uint32_t unit_ns, uint16_t anchor_interval,
+			      struct pcf85063a_ts_index_entry *index, size_t index_size);
+
+/* Continue into a fresh buffer, e.g. after flushing the full one. Starts with an anchor. */
+void pcf85063a_ts_encoder_set_buffer(struct pcf85063a_ts_encoder *enc, uint8_t *buf, size_t size);
+
+/* Append a timestamp in ns since the Unix epoch. -ENOMEM when the buffer is full. */
+int pcf85063a_ts_encode(struct pcf85063a_ts_encoder *enc, int64_t timestamp_ns);
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+/* Append the current RTC anchored wall time, without bus access. */
+int pcf85063a_ts_encode_now(struct pcf85063a_ts_encoder *enc, const struct device *dev);
+#endif
+
+/* -EINVAL for a unit_ns of 0 */
+int pcf85063a_ts_decoder_init(struct pcf85063a_ts_decoder *dec, const uint8_t *buf, size_t len,
+			      uint32_t unit_ns);
+
+/* Next timestamp in ns. -ENODATA at the end, -EBADMSG on a malformed stream. */
+int pcf85063a_ts_decode(struct pcf85063a_ts_decoder *dec, int64_t *timestamp_ns);
+
+/* Position the decoder so the next decode returns the given record. */
+int pcf85063a_ts_seek(struct pcf85063a_ts_decoder *dec, const struct pcf85063a_ts_index_entry *index,
+		      size_t index_len, uint32_t record);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_TS_CODEC_H_ */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_DRIVERS_RTC_PCF85063A_WAKEUP_H_
+#define ZEPHYR_DRIVERS_RTC_PCF85063A_WAKEUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct pcf85063a_wakeup;
+
+/* Runs on the system work queue. May schedule the same wakeup again. */
+typedef void (*pcf85063a_wakeup_handler_t)(struct pcf85063a_wakeup *wakeup);
+
+/*
+ * Wakeup request, owned by the caller. The handler runs no earlier than
+ * deadline_ms and, as far as the countdown resolution allows, no later than
+ * deadline_ms + slack_ms. Requests whose windows overlap share one RTC wake.
+ */
+struct pcf85063a_wakeup
+{
+	pcf85063a_wakeup_handler_t handler;
+
+	/* Private */
+	int64_t deadline_ms;
+	uint32_t slack_ms;
+};
+
+struct pcf85063a_wakeup_stats
+{
+	/* pcf85063a_wakeup_schedule() calls */
+	uint32_t requests;
+	/* Handlers run */
+	uint32_t fired;
+	/* RTC countdown expiries */
+	uint32_t wakes;
+	/* Countdown writes */
+	uint32_t programs;
+};
+
+/*
+ * Run the handler once, at k_uptime_get() == deadline_ms give or take
+ * slack_ms. Rescheduling a pending wakeup moves it. -ENOMEM when
+ * CONFIG_PCF85063A_WAKEUP_MAX requests are already pending.
+ */
+int pcf85063a_wakeup_schedule(struct pcf85063a_wakeup *wakeup, int64_t deadline_ms,
+			      uint32_t slack_ms);
+
+/* Drop a pending wakeup. A handler already being run is not stopped. */
+int pcf85063a_wakeup_cancel(struct pcf85063a_wakeup *wakeup);
+
+int pcf85063a_wakeup_get_stats(struct pcf85063a_wakeup_stats *stats);
+void pcf85063a_wakeup_reset_stats(void);
+
+#endif /* ZEPHYR_DRIVERS_RTC_PCF85063A_WAKEUP_H_ */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Alarm accuracy. Arms CONFIG_APP_ALARMS counter alarms at offsets of 1 to
+ * CONFIG_APP_MAX_OFFSET_S seconds, from varying points within a second, and
+ * records how late each one is seen on three delivery paths: the INT edge
+ * in the GPIO ISR, the counter callback on the work queue, and a thread
+ * woken through k_event. Lateness is against the programmed deadline, so
+ * the countdown's sub-second start phase shows up as early arrivals.
+ *
+ * Delivery latency, from the INT edge to the woken thread, is measured too:
+ * for the alarms above through k_event, and for 64 Hz periodic pulses
+ * through a k_poll_signal.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/counter.h>
+
+#include <stdlib.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+enum path
+{
+	PATH_ISR,
+	PATH_WORK,
+	PATH_THREAD,
+	PATHS,
+};
+
+static const char *const path_names[PATHS] = {"isr", "work", "thread"};
+
+enum delivery
+{
+	DELIVERY_EVENT,
+	DELIVERY_POLL,
+	DELIVERIES,
+};
+
+static const char *const delivery_names[DELIVERIES] = {"k_event", "k_poll"};
+
+static K_EVENT_DEFINE(rtc_events);
+static struct k_poll_signal pulse_signal;
+
+/* Lateness in microseconds, per path */
+static int32_t lateness[PATHS][CONFIG_APP_ALARMS];
+/* INT edge to thread in microseconds, per delivery */
+static int32_t latency[DELIVERIES][CONFIG_APP_ALARMS];
+static volatile uint32_t work_cycles;
+
+static void alarm_callback(const struct device *dev, uint8_t chan_id, uint32_t ticks,
+			   void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(chan_id);
+	ARG_UNUSED(ticks);
+	ARG_UNUSED(user_data);
+
+	work_cycles = k_cycle_get_32();
+}
+
+static void pulse_callback(const struct device *dev, int64_t uptime_ticks, void *user_data)
+{
+	ARG_UNUSED(dev);
+	ARG_UNUSED(uptime_ticks);
+	ARG_UNUSED(user_data);
+}
+
+static int32_t since_int_us(const struct device *rtc, uint32_t woken)
+{
+	return (int32_t)k_cyc_to_us_floor32(woken - pcf85063a_last_int_cycles(rtc));
+}
+
+static int32_t late_us(uint32_t seen, uint32_t armed, uint32_t offset_s)
+{
+	int64_t elapsed = k_cyc_to_us_floor64(seen - armed);
+
+	return (int32_t)(elapsed - (int64_t)offset_s * USEC_PER_SEC);
+}
+
+static int compare(const void *a, const void *b)
+{
+	int32_t x = *(const int32_t *)a;
+	int32_t y = *(const int32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void report(const char *name, int32_t *v, size_t count)
+{
+	qsort(v, count, sizeof(v[0]), compare);
+
+#define PCT(p) v[(count - 1) * (p) / 100]
+	printk("%s: min %d p50 %d p90 %d p99 %d max %d jitter(p99-p1) %d us\n", name, v[0],
+	       PCT(50), PCT(90), PCT(99), v[count - 1], PCT(99) - PCT(1));
+#undef PCT
+}
+
+/* Wait on CONFIG_APP_ALARMS periodic pulses with k_poll */
+static size_t measure_pulses(const struct device *rtc)
+{
+	struct k_poll_event event =
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &pulse_signal);
+	size_t count = 0;
+	uint32_t woken;
+	int ret;
+
+	k_poll_signal_init(&pulse_signal);
+	pcf85063a_set_alarm_signal(rtc, PCF85063A_ALARM_COUNTDOWN, &pulse_signal);
+
+	ret = pcf85063a_set_periodic(rtc, PCF85063A_TIMER_MODE_FREQ_64, 1, pulse_callback, NULL);
+	if (ret)
+	{
+		LOG_ERR("Unable to start pulses. (err %i)", ret);
+		return 0;
+	}
+
+	while (count < CONFIG_APP_ALARMS)
+	{
+		if (k_poll(&event, 1, K_SECONDS(1)))
+		{
+			LOG_WRN("Pulse %zu did not arrive.", count);
+			break;
+		}
+
+		woken = k_cycle_get_32();
+		latency[DELIVERY_POLL][count++] = since_int_us(rtc, woken);
+
+		k_poll_signal_reset(&pulse_signal);
+		event.state = K_POLL_STATE_NOT_READY;
+	}
+
+	counter_cancel_channel_alarm(rtc, 0);
+	pcf85063a_set_alarm_signal(rtc, PCF85063A_ALARM_COUNTDOWN, NULL);
+
+	return count;
+}
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+	size_t count = 0, pulses;
+	int ret;
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready.");
+		return 0;
+	}
+
+	pcf85063a_set_alarm_event(rtc, &rtc_events);
+
+	for (size_t i = 0; i < CONFIG_APP_ALARMS; i++)
+	{
+		uint32_t offset = 1 + i % CONFIG_APP_MAX_OFFSET_S;
+		struct counter_alarm_cfg cfg = {
+			.ticks = offset,
+			.callback = alarm_callback,
+		};
+		uint32_t armed, woken;
+
+		// Spread the arm time across the RTC second
+		k_msleep((i * 137) % MSEC_PER_SEC);
+
+		work_cycles = 0;
+		armed = k_cycle_get_32();
+
+		ret = counter_set_channel_alarm(rtc, 0, &cfg);
+		if (ret)
+		{
+			LOG_ERR("Unable to set alarm. (err %i)", ret);
+			return 0;
+		}
+
+		if (!k_event_wait(&rtc_events, BIT(PCF85063A_ALARM_COUNTDOWN), true,
+				  K_SECONDS(offset + 2)))
+		{
+			LOG_WRN("Alarm %zu did not fire.", i);
+			counter_cancel_channel_alarm(rtc, 0);
+			continue;
+		}
+
+		woken = k_cycle_get_32();
+
+		// The callback runs right after the event is posted, on the same queue
+		while (!work_cycles)
+		{
+			k_yield();
+		}
+
+		lateness[PATH_ISR][count] = late_us(pcf85063a_last_int_cycles(rtc), armed, offset);
+		lateness[PATH_WORK][count] = late_us(work_cycles, armed, offset);
+		lateness[PATH_THREAD][count] = late_us(woken, armed, offset);
+		latency[DELIVERY_EVENT][count] = since_int_us(rtc, woken);
+		count++;
+	}
+
+	if (count == 0)
+	{
+		LOG_ERR("No alarms fired.");
+		return 0;
+	}
+
+	printk("%zu alarms, 1 to %u s\n", count, CONFIG_APP_MAX_OFFSET_S);
+
+	for (int path = 0; path < PATHS; path++)
+	{
+		report(path_names[path], lateness[path], count);
+	}
+
+	// Pulses would post to rtc_events as well
+	pcf85063a_set_alarm_event(rtc, NULL);
+	pulses = measure_pulses(rtc);
+
+	printk("Delivery latency, INT edge to thread\n");
+	report(delivery_names[DELIVERY_EVENT], latency[DELIVERY_EVENT], count);
+	if (pulses)
+	{
+		report(delivery_names[DELIVERY_POLL], latency[DELIVERY_POLL], pulses);
+	}
+
+	return 0;
+}
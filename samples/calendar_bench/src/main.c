@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Calendar arithmetic benchmark. Converts CONFIG_APP_DATES pseudo random
+ * times in 2000-2099 both ways, once through libc and Zephyr's timeutil and
+ * once through pcf85063a_calendar.h, and prints the cost per conversion.
+ * Every result is cross checked, the run ends with the mismatch count.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/timeutil.h>
+
+#include <time.h>
+
+#include <drivers/counter/pcf85063a_calendar.h>
+
+/* 2000-01-01 and 100 years on */
+#define FIRST_EPOCH 946684800LL
+#define SPAN_S (36525LL * PCF85063A_SECONDS_PER_DAY)
+
+static uint32_t seed;
+
+/* Same generator in every loop, so its cost cancels in the comparison */
+static int64_t next_epoch(void)
+{
+	seed = seed * 1664525U + 1013904223U;
+
+	return FIRST_EPOCH + (int64_t)seed * SPAN_S / UINT32_MAX;
+}
+
+static volatile int64_t sink;
+
+static void bench(const char *name, void (*convert)(int64_t epoch))
+{
+	uint32_t start, cycles;
+
+	seed = 1;
+	start = k_cycle_get_32();
+	for (int i = 0; i < CONFIG_APP_DATES; i++)
+	{
+		convert(next_epoch());
+	}
+	cycles = k_cycle_get_32() - start;
+
+	printk("%-28s %u ns\n", name, (uint32_t)(k_cyc_to_ns_floor64(cycles) / CONFIG_APP_DATES));
+}
+
+static void libc_to_tm(int64_t epoch)
+{
+	time_t t = (time_t)epoch;
+	struct tm time;
+
+	gmtime_r(&t, &time);
+	sink += time.tm_mday + time.tm_wday + time.tm_yday;
+}
+
+static void pcf_to_tm(int64_t epoch)
+{
+	struct tm time;
+
+	pcf85063a_epoch_to_tm(epoch, &time);
+	sink += time.tm_mday + time.tm_wday + time.tm_yday;
+}
+
+static void libc_to_epoch(int64_t epoch)
+{
+	struct tm time = {
+		.tm_year = 100 + (int)(epoch % 100),
+		.tm_mon = (int)(epoch % 12),
+		.tm_mday = 1 + (int)(epoch % 28),
+	};
+
+	sink += timeutil_timegm64(&time);
+}
+
+static void pcf_to_epoch(int64_t epoch)
+{
+	struct tm time = {
+		.tm_year = 100 + (int)(epoch % 100),
+		.tm_mon = (int)(epoch % 12),
+		.tm_mday = 1 + (int)(epoch % 28),
+	};
+
+	sink += pcf85063a_tm_to_epoch(&time);
+}
+
+static uint32_t check(void)
+{
+	uint32_t mismatches = 0;
+	struct tm a, b;
+	time_t t;
+
+	seed = 1;
+	for (int i = 0; i < CONFIG_APP_DATES; i++)
+	{
+		t = (time_t)next_epoch();
+		gmtime_r(&t, &a);
+		pcf85063a_epoch_to_tm(t, &b);
+
+		if (a.tm_year != b.tm_year || a.tm_mon != b.tm_mon || a.tm_mday != b.tm_mday ||
+		    a.tm_hour != b.tm_hour || a.tm_min != b.tm_min || a.tm_sec != b.tm_sec ||
+		    a.tm_wday != b.tm_wday || a.tm_yday != b.tm_yday ||
+		    pcf85063a_tm_to_epoch(&a) != timeutil_timegm64(&a))
+		{
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+int main(void)
+{
+	printk("Calendar conversions, %d dates each:\n", CONFIG_APP_DATES);
+
+	bench("gmtime_r", libc_to_tm);
+	bench("pcf85063a_epoch_to_tm", pcf_to_tm);
+	bench("timeutil_timegm64", libc_to_epoch);
+	bench("pcf85063a_tm_to_epoch", pcf_to_epoch);
+
+	printk("Mismatches: %u\n", check());
+
+	return 0;
+}
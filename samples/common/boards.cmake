@@ -0,0 +1,32 @@
+#
+# Copyright (c) 2022 Circuit Dojo LLC
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+
+# Board files for the samples that talk to the RTC, shared instead of a
+# boards/ directory in each sample. Include before find_package(Zephyr).
+# Looks for the full board target first, e.g. nrf52840dk_nrf52840, then the
+# board name alone.
+
+set(PCF85063A_SAMPLE_BOARDS ${CMAKE_CURRENT_LIST_DIR}/boards)
+
+# Zephyr only resolves BOARD from the environment inside find_package
+if(DEFINED BOARD)
+  set(pcf85063a_board ${BOARD})
+else()
+  set(pcf85063a_board $ENV{BOARD})
+endif()
+
+string(REPLACE "/" "_" pcf85063a_board_target "${pcf85063a_board}")
+string(REGEX REPLACE "/.*" "" pcf85063a_board_name "${pcf85063a_board}")
+
+foreach(name ${pcf85063a_board_target} ${pcf85063a_board_name})
+  if(EXISTS ${PCF85063A_SAMPLE_BOARDS}/${name}.overlay)
+    list(APPEND EXTRA_DTC_OVERLAY_FILE ${PCF85063A_SAMPLE_BOARDS}/${name}.overlay)
+    if(EXISTS ${PCF85063A_SAMPLE_BOARDS}/${name}.conf)
+      list(APPEND EXTRA_CONF_FILE ${PCF85063A_SAMPLE_BOARDS}/${name}.conf)
+    endif()
+    break()
+  endif()
+endforeach()
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+	struct tm time;
+
+	if (!device_is_ready(rtc))
+	{
+		return 0;
+	}
+
+	/* Keep the one API every profile provides referenced */
+	pcf85063a_get_time(rtc, &time);
+	pcf85063a_set_time(rtc, &time);
+
+	return 0;
+}
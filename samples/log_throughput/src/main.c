@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Log throughput benchmark. Logs CONFIG_APP_MESSAGES messages in bursts that
+ * fit the deferred log buffer and times only the logging calls: timestamp,
+ * argument packaging and buffer allocation. Build once with and once without
+ * CONFIG_PCF85063A_LOG_TIMESTAMP and compare the per message cost. The
+ * timestamp paths are also timed on their own.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/logging/log_ctrl.h>
+
+#include <drivers/counter/pcf85063a.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+/* Time for the log timestamp provider to install */
+#define PROVIDER_WAIT_MS 1500
+
+static volatile int64_t sink;
+
+static uint32_t per_call_ns(uint32_t cycles, uint32_t calls)
+{
+	return (uint32_t)(k_cyc_to_ns_floor64(cycles) / calls);
+}
+
+static void bench_timestamps(const struct device *rtc)
+{
+	uint32_t start, cycles;
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < CONFIG_APP_MESSAGES; i++)
+	{
+		sink += k_uptime_ticks();
+	}
+	cycles = k_cycle_get_32() - start;
+
+	printk("Uptime timestamp: %u ns\n", per_call_ns(cycles, CONFIG_APP_MESSAGES));
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+	int64_t ticks;
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < CONFIG_APP_MESSAGES; i++)
+	{
+		pcf85063a_get_realtime_ticks(rtc, &ticks);
+		sink += ticks;
+	}
+	cycles = k_cycle_get_32() - start;
+
+	printk("RTC timestamp: %u ns\n", per_call_ns(cycles, CONFIG_APP_MESSAGES));
+#else
+	ARG_UNUSED(rtc);
+#endif
+}
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+	uint32_t start, cycles = 0;
+	struct tm time;
+	int ret;
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready.");
+		return 0;
+	}
+
+	// A fresh RTC has no time, give it one so the anchor means something
+	if (pcf85063a_get_time(rtc, &time) == -EIO)
+	{
+		time = (struct tm){.tm_year = 124, .tm_mday = 1};
+
+		ret = pcf85063a_set_time(rtc, &time);
+		if (ret)
+		{
+			LOG_ERR("Unable to set time. (err %i)", ret);
+			return 0;
+		}
+	}
+
+#ifdef CONFIG_PCF85063A_ANCHOR
+	ret = pcf85063a_sync_anchor(rtc);
+	if (ret)
+	{
+		LOG_ERR("Unable to anchor RTC time. (err %i)", ret);
+		return 0;
+	}
+#endif
+
+#ifdef CONFIG_PCF85063A_LOG_TIMESTAMP
+	// The provider installs itself on its next resync, retried every second
+	k_msleep(PROVIDER_WAIT_MS);
+#endif
+
+	bench_timestamps(rtc);
+
+	for (int done = 0; done < CONFIG_APP_MESSAGES; done += CONFIG_APP_BURST)
+	{
+		int burst = MIN(CONFIG_APP_BURST, CONFIG_APP_MESSAGES - done);
+
+		start = k_cycle_get_32();
+		for (int i = 0; i < burst; i++)
+		{
+			LOG_INF("Message %d", done + i);
+		}
+		cycles += k_cycle_get_32() - start;
+
+		// The log thread runs at a lower priority, let it catch up
+		while (log_data_pending())
+		{
+			k_msleep(10);
+		}
+	}
+
+	printk("Log timestamps: %s\n",
+	       IS_ENABLED(CONFIG_PCF85063A_LOG_TIMESTAMP) ? "RTC wall time" : "uptime");
+	printk("Per message: %u ns\n", per_call_ns(cycles, CONFIG_APP_MESSAGES));
+
+	return 0;
+}
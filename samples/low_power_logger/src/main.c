@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Low power data logger. Sleeps until the RTC countdown fires, takes a
+ * reading, stamps it from the RTC anchor without touching the bus and queues
+ * it. Full batches are written out in one go. After CONFIG_APP_RECORDS
+ * records it reports what each one cost; on native_sim the RTC is the
+ * emulator, which counts the I2C traffic.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_ts_codec.h>
+
+#ifdef CONFIG_PCF85063A_EMUL
+#include <zephyr/drivers/emul.h>
+#include <drivers/counter/pcf85063a_emul.h>
+#endif
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+static K_EVENT_DEFINE(rtc_events);
+
+/* One batch of readings and their encoded timestamps */
+static int16_t values[CONFIG_APP_BATCH_RECORDS];
+static uint8_t timestamps[CONFIG_APP_BATCH_RECORDS * 10];
+static struct pcf85063a_ts_encoder encoder;
+
+static uint32_t wakeups;
+
+/* Stand-in for a sensor */
+static int16_t read_sensor(void)
+{
+	static int16_t value;
+
+	return value++ % 100;
+}
+
+/* Stand-in for a flash write */
+static void write_batch(uint32_t count)
+{
+	LOG_INF("Batch of %u records, %zu timestamp bytes.", count, encoder.len);
+
+	pcf85063a_ts_encoder_set_buffer(&encoder, timestamps, sizeof(timestamps));
+}
+
+static void report(uint32_t records, uint64_t awake_cycles)
+{
+	uint32_t awake_us = (uint32_t)k_cyc_to_us_floor64(awake_cycles);
+
+#ifdef CONFIG_PCF85063A_EMUL
+	struct pcf85063a_emul_stats bus;
+
+	pcf85063a_emul_get_stats(EMUL_DT_GET(DT_NODELABEL(pcf85063a)), &bus);
+
+	LOG_INF("Bus: %u transfers, %u bytes, %u RTC interrupts.", bus.transfers, bus.bus_bytes,
+		bus.interrupts);
+
+	if (bus.invalid_dates)
+	{
+		LOG_WRN("%u invalid dates written, the figures below are not valid.",
+			bus.invalid_dates);
+	}
+
+	printk("Per record: %u.%02u I2C bytes, %u.%02u wakeups, %u us awake\n",
+	       bus.bus_bytes / records, bus.bus_bytes * 100 / records % 100, wakeups / records,
+	       wakeups * 100 / records % 100, awake_us / records);
+#else
+	printk("Per record: %u.%02u wakeups, %u us awake\n", wakeups / records,
+	       wakeups * 100 / records % 100, awake_us / records);
+#endif
+}
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+	k_thread_runtime_stats_t start, end;
+	uint32_t records = 0, batched = 0;
+	struct tm time;
+	int ret;
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready.");
+		return 0;
+	}
+
+	// A fresh RTC has no time, give it one so the anchor means something
+	if (pcf85063a_get_time(rtc, &time) == -EIO)
+	{
+		time = (struct tm){.tm_year = 124, .tm_mday = 1};
+
+		ret = pcf85063a_set_time(rtc, &time);
+		if (ret)
+		{
+			LOG_ERR("Unable to set time. (err %i)", ret);
+			return 0;
+		}
+	}
+
+	// Timestamps come from here on, without bus reads
+	ret = pcf85063a_sync_anchor(rtc);
+	if (ret)
+	{
+		LOG_ERR("Unable to anchor RTC time. (err %i)", ret);
+		return 0;
+	}
+
+	pcf85063a_set_alarm_event(rtc, &rtc_events);
+	pcf85063a_ts_encoder_init(&encoder, timestamps, sizeof(timestamps), NSEC_PER_MSEC,
+				  CONFIG_APP_BATCH_RECORDS, NULL, 0);
+
+#ifdef CONFIG_PCF85063A_EMUL
+	pcf85063a_emul_reset_stats(EMUL_DT_GET(DT_NODELABEL(pcf85063a)));
+#endif
+	k_thread_runtime_stats_all_get(&start);
+
+	while (records < CONFIG_APP_RECORDS)
+	{
+		ret = pcf85063a_set_countdown(rtc, PCF85063A_TIMER_MODE_FREQ_1, CONFIG_APP_LOG_PERIOD_S,
+					      NULL, NULL);
+		if (ret)
+		{
+			LOG_ERR("Unable to arm RTC wakeup. (err %i)", ret);
+			return 0;
+		}
+
+		k_event_wait(&rtc_events, BIT(PCF85063A_ALARM_COUNTDOWN), true, K_FOREVER);
+		wakeups++;
+
+		values[batched] = read_sensor();
+		pcf85063a_ts_encode_now(&encoder, rtc);
+		batched++;
+		records++;
+
+		if (batched == CONFIG_APP_BATCH_RECORDS)
+		{
+			write_batch(batched);
+			batched = 0;
+		}
+	}
+
+	k_thread_runtime_stats_all_get(&end);
+
+	report(records, end.total_cycles - start.total_cycles);
+
+	return 0;
+}
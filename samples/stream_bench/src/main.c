@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Stream timestamp benchmark. Timestamps CONFIG_APP_BATCHES batches of
+ * CONFIG_APP_SAMPLES samples at CONFIG_APP_RATE_HZ twice: with
+ * pcf85063a_stream_fill, and per sample by interpolating the sample's uptime
+ * and adding the anchor offset. Prints the cost per sample of each and the
+ * largest difference between their results, which rounding keeps to 1 ns.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+#include <stdlib.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_stream.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+static int64_t filled[CONFIG_APP_SAMPLES];
+static int64_t interpolated[CONFIG_APP_SAMPLES];
+
+static uint32_t per_sample_ns(uint32_t cycles)
+{
+	return (uint32_t)(k_cyc_to_ns_floor64(cycles) /
+			  ((uint64_t)CONFIG_APP_BATCHES * CONFIG_APP_SAMPLES));
+}
+
+/* The usual way: uptime of each sample from its index, then through the anchor */
+static void interpolate(const struct device *rtc, int64_t first_uptime_ns, uint32_t first,
+			int64_t *timestamps, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		int64_t uptime_ns = first_uptime_ns +
+				    (int64_t)(first + i) * NSEC_PER_SEC / CONFIG_APP_RATE_HZ;
+
+		timestamps[i] = uptime_ns + pcf85063a_realtime_ticks_to_ns(
+						    pcf85063a_anchor_offset_ticks(rtc->data));
+	}
+}
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+	struct pcf85063a_stream stream;
+	uint32_t start, fill_cycles = 0, interpolate_cycles = 0;
+	int64_t first_ticks, diff, max_diff = 0;
+	struct tm time;
+	int ret;
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready.");
+		return 0;
+	}
+
+	// A fresh RTC has no time, give it one so the anchor means something
+	if (pcf85063a_get_time(rtc, &time) == -EIO)
+	{
+		time = (struct tm){.tm_year = 124, .tm_mday = 1};
+
+		ret = pcf85063a_set_time(rtc, &time);
+		if (ret)
+		{
+			LOG_ERR("Unable to set time. (err %i)", ret);
+			return 0;
+		}
+	}
+
+	// Starting the stream captures the anchor both methods use
+	first_ticks = k_uptime_ticks();
+	ret = pcf85063a_stream_start(&stream, rtc, CONFIG_APP_RATE_HZ, 0, first_ticks);
+	if (ret)
+	{
+		LOG_ERR("Unable to start stream. (err %i)", ret);
+		return 0;
+	}
+
+	for (uint32_t batch = 0; batch < CONFIG_APP_BATCHES; batch++)
+	{
+		start = k_cycle_get_32();
+		pcf85063a_stream_fill(&stream, filled, CONFIG_APP_SAMPLES);
+		fill_cycles += k_cycle_get_32() - start;
+
+		start = k_cycle_get_32();
+		interpolate(rtc, k_ticks_to_ns_floor64(first_ticks), batch * CONFIG_APP_SAMPLES,
+			    interpolated, CONFIG_APP_SAMPLES);
+		interpolate_cycles += k_cycle_get_32() - start;
+
+		for (size_t i = 0; i < CONFIG_APP_SAMPLES; i++)
+		{
+			diff = llabs(filled[i] - interpolated[i]);
+			max_diff = MAX(max_diff, diff);
+		}
+	}
+
+	printk("Stream fill: %u ns per sample\n", per_sample_ns(fill_cycles));
+	printk("Per sample interpolation: %u ns per sample\n", per_sample_ns(interpolate_cycles));
+	printk("Max difference: %lld ns\n", (long long)max_diff);
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Timestamp codec benchmark. Encodes CONFIG_APP_RECORDS timestamps for a few
+ * typical workloads, prints the encode and decode cost per record and the
+ * bytes per record against 8 for a raw int64_t, then decodes the stream and
+ * checks every value against the quantized input. The run ends with the
+ * mismatch count.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <drivers/counter/pcf85063a_ts_codec.h>
+
+/* 2024-01-01 in ns */
+#define START_NS (1704067200LL * NSEC_PER_SEC)
+
+struct workload
+{
+	const char *name;
+	uint32_t unit_ns;
+	int64_t step_ns;
+	/* Each step varies by up to this much either way */
+	int64_t jitter_ns;
+};
+
+static const struct workload workloads[] = {
+	{"1 kHz, us units", NSEC_PER_USEC, NSEC_PER_MSEC, 0},
+	{"1 kHz +-50 us, us units", NSEC_PER_USEC, NSEC_PER_MSEC, 50 * NSEC_PER_USEC},
+	{"1 Hz, ms units", NSEC_PER_MSEC, NSEC_PER_SEC, 0},
+	{"1/min +-2 s, ms units", NSEC_PER_MSEC, 60LL * NSEC_PER_SEC, 2LL * NSEC_PER_SEC},
+};
+
+/* Worst case is a full width anchor per record */
+static uint8_t stream[CONFIG_APP_RECORDS * 10];
+static int64_t input[CONFIG_APP_RECORDS];
+
+static uint32_t mismatches;
+static uint32_t seed;
+
+/* Repeatable jitter, so runs compare */
+static int64_t next_jitter(int64_t jitter_ns)
+{
+	seed = seed * 1664525U + 1013904223U;
+
+	return (int64_t)(seed % (uint32_t)(2 * jitter_ns + 1)) - jitter_ns;
+}
+
+static uint32_t per_record_ns(uint32_t cycles)
+{
+	return (uint32_t)(k_cyc_to_ns_floor64(cycles) / CONFIG_APP_RECORDS);
+}
+
+static void generate(const struct workload *load)
+{
+	int64_t t = START_NS;
+
+	seed = 1;
+
+	for (int i = 0; i < CONFIG_APP_RECORDS; i++)
+	{
+		input[i] = t;
+		t += load->step_ns;
+
+		if (load->jitter_ns)
+		{
+			t += next_jitter(load->jitter_ns);
+		}
+	}
+}
+
+static void bench(const struct workload *load)
+{
+	struct pcf85063a_ts_encoder enc;
+	struct pcf85063a_ts_decoder dec;
+	uint32_t start, encode_cycles, decode_cycles;
+	int64_t ns;
+	int ret;
+
+	generate(load);
+
+	ret = pcf85063a_ts_encoder_init(&enc, stream, sizeof(stream), load->unit_ns,
+					CONFIG_APP_ANCHOR_INTERVAL, NULL, 0);
+	if (ret)
+	{
+		printk("Unable to init encoder. (err %i)\n", ret);
+		mismatches++;
+		return;
+	}
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < CONFIG_APP_RECORDS; i++)
+	{
+		pcf85063a_ts_encode(&enc, input[i]);
+	}
+	encode_cycles = k_cycle_get_32() - start;
+
+	pcf85063a_ts_decoder_init(&dec, stream, enc.len, load->unit_ns);
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < CONFIG_APP_RECORDS; i++)
+	{
+		ret = pcf85063a_ts_decode(&dec, &ns);
+
+		// Compare against the input quantized the way the encoder does
+		if (ret || ns != input[i] / load->unit_ns * load->unit_ns)
+		{
+			mismatches++;
+		}
+	}
+	decode_cycles = k_cycle_get_32() - start;
+
+	printk("%-26s %3u.%02u B/record (raw 8), encode %u ns, decode %u ns\n", load->name,
+	       (uint32_t)(enc.len / CONFIG_APP_RECORDS),
+	       (uint32_t)(enc.len * 100 / CONFIG_APP_RECORDS % 100), per_record_ns(encode_cycles),
+	       per_record_ns(decode_cycles));
+}
+
+int main(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(workloads); i++)
+	{
+		bench(&workloads[i]);
+	}
+
+	printk("Mismatches: %u\n", mismatches);
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022 Circuit Dojo LLC
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Wakeup coalescing. A handful of subsystems each want a periodic RTC
+ * wakeup, at periods that are a few seconds apart. The workload runs for
+ * CONFIG_APP_DURATION_S with no slack and again with CONFIG_APP_SLACK_MS.
+ * Each run prints how many handlers ran per RTC wake.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+#include <drivers/counter/pcf85063a.h>
+#include <drivers/counter/pcf85063a_wakeup.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
+
+#define RTC DEVICE_DT_GET(DT_NODELABEL(pcf85063a))
+
+struct subsystem
+{
+	const char *name;
+	uint32_t period_ms;
+	struct pcf85063a_wakeup wakeup;
+	int64_t next_ms;
+};
+
+static struct subsystem subsystems[] = {
+	{.name = "sensor", .period_ms = 10000},	 {.name = "battery", .period_ms = 12000},
+	{.name = "gnss", .period_ms = 15000},	 {.name = "modem", .period_ms = 20000},
+	{.name = "watchdog", .period_ms = 30000}, {.name = "upload", .period_ms = 45000},
+};
+
+static uint32_t slack_ms;
+
+static void subsystem_wake(struct pcf85063a_wakeup *wakeup)
+{
+	struct subsystem *sub = CONTAINER_OF(wakeup, struct subsystem, wakeup);
+
+	// Keep to the nominal schedule however late this wake was
+	sub->next_ms += sub->period_ms;
+	pcf85063a_wakeup_schedule(&sub->wakeup, sub->next_ms, slack_ms);
+}
+
+static void run(uint32_t slack)
+{
+	struct pcf85063a_wakeup_stats stats;
+	int64_t start = k_uptime_get();
+
+	slack_ms = slack;
+	pcf85063a_wakeup_reset_stats();
+
+	for (size_t i = 0; i < ARRAY_SIZE(subsystems); i++)
+	{
+		struct subsystem *sub = &subsystems[i];
+
+		sub->wakeup.handler = subsystem_wake;
+		sub->next_ms = start + sub->period_ms;
+		pcf85063a_wakeup_schedule(&sub->wakeup, sub->next_ms, slack_ms);
+	}
+
+	k_sleep(K_SECONDS(CONFIG_APP_DURATION_S));
+
+	for (size_t i = 0; i < ARRAY_SIZE(subsystems); i++)
+	{
+		pcf85063a_wakeup_cancel(&subsystems[i].wakeup);
+	}
+
+	pcf85063a_wakeup_get_stats(&stats);
+
+	printk("Slack %u ms: %u handlers, %u RTC wakes, %u countdown writes\n", slack, stats.fired,
+	       stats.wakes, stats.programs);
+	printk("Merged wake ratio: %u.%02u handlers per wake\n",
+	       stats.wakes ? stats.fired / stats.wakes : 0,
+	       stats.wakes ? stats.fired * 100 / stats.wakes % 100 : 0);
+}
+
+int main(void)
+{
+	const struct device *const rtc = RTC;
+
+	if (!device_is_ready(rtc))
+	{
+		LOG_ERR("RTC not ready.");
+		return 0;
+	}
+
+	run(0);
+	run(CONFIG_APP_SLACK_MS);
+
+	return 0;
+}
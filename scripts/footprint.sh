@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Copyright (c) 2022 Circuit Dojo LLC
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Build samples/footprint once per driver profile and report the ROM and RAM
+# taken by the driver objects and by the whole image.
+#
+# Usage: scripts/footprint.sh [board]
+#
+
+BOARD=${1:-nrf52840dk_nrf52840}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SIZE=${SIZE:-arm-zephyr-eabi-size}
+
+mkdir -p "$ROOT/build"
+
+printf "%-10s %10s %10s %12s %12s\n" profile drv_rom drv_ram image_rom image_ram
+
+for profile in full minimal; do
+	build="$ROOT/build/footprint-$profile"
+	extra=""
+	[ "$profile" != full ] && extra="-DEXTRA_CONF_FILE=$profile.conf"
+
+	west build -p always -b "$BOARD" -d "$build" "$ROOT/samples/footprint" -- $extra > "$build.log" 2>&1 || {
+		echo "$profile: build failed, see $build.log"
+		continue
+	}
+
+	# text + data live in ROM, data + bss in RAM
+	drv=$(find "$build" -name 'pcf85063a*.obj' -exec "$SIZE" {} + |
+		awk 'NR > 1 { rom += $1 + $2; ram += $2 + $3 } END { print rom, ram }')
+	img=$("$SIZE" "$build/zephyr/zephyr.elf" |
+		awk 'NR == 2 { print $1 + $2, $2 + $3 }')
+
+	printf "%-10s %10s %10s %12s %12s\n" "$profile" $drv $img
+done